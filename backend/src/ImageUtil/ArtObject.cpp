@@ -4,6 +4,9 @@ namespace btrgb {
 
     ArtObject::ArtObject(std::string ref_file, IlluminantType ilumination, ObserverType observer, std::string output_directory) {
         this->ref_data = new RefData(ref_file, ilumination, observer);
+        this->ref_file = ref_file;
+        this->illuminant = ilumination;
+        this->observer = observer;
 
         bool is_windows = output_directory.front() != '/';
         if( is_windows && output_directory.back() != '\\' )
@@ -36,6 +39,7 @@ namespace btrgb {
     * Creates and maps a new image.
     */
     void ArtObject::newImage(std::string name, std::string filename) {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
 
         if(this->images.contains(name))
             throw ArtObj_ImageAlreadyExists();
@@ -54,10 +58,10 @@ namespace btrgb {
     // This asumes that the imageName specified actualy contains a color target
     ColorTarget ArtObject::get_target(std::string imageName, TargetType type){
         // If a target is requested and it does not exist it must then be in the art image
-        if(imageName == TARGET(1) && !this->images.contains(imageName)){
+        if(imageName == TARGET(1) && !this->imageExists(imageName)){
             imageName = ART(1);
         }
-        if(imageName == TARGET(2) && !this->images.contains(imageName)){
+        if(imageName == TARGET(2) && !this->imageExists(imageName)){
             imageName = ART(2);
         }
 
@@ -132,6 +136,7 @@ namespace btrgb {
     * If the name is used, throws ArtObj_ImageAlreadyExists.
     */
     void ArtObject::setImage(std::string name, Image* im) {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
 
         if (this->images.contains(name))
             throw ArtObj_ImageAlreadyExists();
@@ -145,6 +150,7 @@ namespace btrgb {
     * is found in memory, otherwise throws ArtObj_ImageDoesNotExist.
     */
     Image* ArtObject::getImage(std::string name) {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
 
         if(this->images.contains(name))
             return this->images[name];
@@ -154,6 +160,7 @@ namespace btrgb {
 
 
     void ArtObject::deleteImage(std::string name) {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
         if( ! this->images.contains(name) )
             throw ArtObj_ImageDoesNotExist();
 
@@ -166,6 +173,7 @@ namespace btrgb {
     * Returns a boolean to indicate if an image is stored in memory.
     */
     bool ArtObject::imageExists(std::string name) {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
         return this->images.contains(name);
     }
 
@@ -175,13 +183,16 @@ namespace btrgb {
      */
     void ArtObject::outputImageAs(enum output_type filetype, std::string name, std::string filename) {
 
-        if (! this->images.contains(name))
-            throw ArtObj_ImageDoesNotExist();
+        Image* im = this->getImage(name);
 
         try {
             if(filename == "")
                 filename = name;
-            ImageWriter(filetype).write( this->images[name], this->output_directory + filename );
+            TraceSpan span(this->get_trace(), "Write " + filename, "io");
+            cv::Mat m = im->getMat();
+            span.set_pixels(m.total());
+            span.set_bytes(int64_t(m.total()) * m.elemSize());
+            ImageWriter(filetype).write( im, this->output_directory + filename );
 
         }
         catch (ImageWritingError const& e) {
@@ -200,10 +211,108 @@ namespace btrgb {
         return this->ref_data;
     }
 
+    std::unique_ptr<ArtObject> ArtObject::target_preview(double margin) {
+        std::unique_ptr<ArtObject> preview(new ArtObject(this->ref_file, this->illuminant, this->observer, this->output_directory));
+        TargetData preview_td = this->target_data;
+
+        // The target is in the art image when no seperate target image was given
+        Image* sources[2];
+        for (int set = 1; set <= 2; set++) {
+            std::string num = std::to_string(set);
+            sources[set - 1] = this->getImage(this->imageExists("target" + num) ? "target" + num : "art" + num);
+        }
+
+        // Both sets share one target location, so they are cropped to the same region
+        if (sources[0]->width() != sources[1]->width() || sources[0]->height() != sources[1]->height())
+            throw ArtObj_MismatchedSets();
+
+        // The front end normalizes the location based on width, so multiply top by width instead of height
+        int img_width = sources[0]->width();
+        double left = this->target_data.left_loc * img_width;
+        double top = this->target_data.top_loc * img_width;
+        double right = this->target_data.right_loc * img_width;
+        double bottom = this->target_data.bot_loc * img_width;
+        int margin_x = (right - left) * margin;
+        int margin_y = (bottom - top) * margin;
+        cv::Rect region(left - margin_x, top - margin_y, (right - left) + 2 * margin_x, (bottom - top) + 2 * margin_y);
+        region &= cv::Rect(0, 0, sources[0]->width(), sources[0]->height());
+
+        for (int set = 1; set <= 2; set++) {
+            std::string num = std::to_string(set);
+
+            // Crop the target, white and dark images of this set
+            std::string names[] = {"art" + num, "white" + num, "dark" + num};
+            Image* crop_sources[] = {sources[set - 1], this->getImage("white" + num), this->getImage("dark" + num)};
+            for (int i = 0; i < 3; i++) {
+                Image* crop = new Image(crop_sources[i]->getName());
+                crop->initImage(crop_sources[i]->getMat()(region).clone());
+                crop->_raw_bit_depth = crop_sources[i]->_raw_bit_depth;
+                crop->setExifTags(crop_sources[i]->getExifTags());
+                preview->setImage(names[i], crop);
+            }
+        }
+
+        // Renormalize target location to the cropped images, still based on width
+        preview_td.left_loc = (left - region.x) / region.width;
+        preview_td.top_loc = (top - region.y) / region.width;
+        preview_td.right_loc = (right - region.x) / region.width;
+        preview_td.bot_loc = (bottom - region.y) / region.width;
+
+        preview->setTargetInfo(preview_td);
+        preview->set_cancellation_token(this->cancel_token);
+        preview->set_trace(this->trace);
+        return preview;
+    }
+
+    void ArtObject::set_cancellation_token(std::shared_ptr<CancellationToken> token) {
+        this->cancel_token = token;
+    }
+
+    std::shared_ptr<CancellationToken> ArtObject::get_cancellation_token() {
+        return this->cancel_token;
+    }
+
+    void ArtObject::check_cancelled() {
+        if(nullptr != this->cancel_token)
+            this->cancel_token->throw_if_cancelled();
+    }
+
+    void ArtObject::set_trace(std::shared_ptr<Trace> trace) {
+        this->trace = trace;
+    }
+
+    Trace* ArtObject::get_trace() {
+        return this->trace.get();
+    }
+
     int ArtObject::imageCount(){
+      std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
       return this->images.size();
     }
 
+    int64_t ArtObject::pixelCount() {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
+        int64_t count = 0;
+        for(const auto& [key, im] : this->images) {
+            try { count += int64_t(im->width()) * im->height(); }
+            catch(const ImageNotInitialized& e) { /* Not read yet */ }
+        }
+        return count;
+    }
+
+    int64_t ArtObject::byteCount() {
+        std::unique_lock<std::recursive_mutex> lock(this->images_mutex);
+        int64_t count = 0;
+        for(const auto& [key, im] : this->images) {
+            try {
+                cv::Mat m = im->getMat();
+                count += int64_t(m.total()) * m.elemSize();
+            }
+            catch(const ImageNotInitialized& e) { /* Not read yet */ }
+        }
+        return count;
+    }
+
     std::string ArtObject::get_output_dir(){
         return this->output_directory;
     }
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "ImageUtil/Image.hpp"
@@ -10,6 +12,8 @@
 #include "reference_data/ref_data.hpp"
 #include "ImageUtil/ColorTarget.hpp"
 #include "image_processing/results/calibration_results.hpp"
+#include "utils/cancellation_token.hpp"
+#include "utils/trace.hpp"
 
 // Macros for identifying images in "images" map
 // Example ART(1) will expand to "art1" ART(2) will expand to "art2"
@@ -55,12 +59,19 @@ namespace btrgb {
     private:
         TargetData target_data, verification_data;
         std::unordered_map<std::string, Image*> images;
+        // Guards the image map, components that run concurrently add and remove images side by side
+        std::recursive_mutex images_mutex;
         RefData* ref_data;
         RefData* verification_ref = nullptr;
+        std::string ref_file;
+        IlluminantType illuminant;
+        ObserverType observer;
         std::string output_directory;
         CalibrationResults general_info;
         CalibrationResults calibration_res; 
         CalibrationResults verification_res;
+        std::shared_ptr<CancellationToken> cancel_token;
+        std::shared_ptr<Trace> trace;
 
     public:
         ArtObject(std::string ref_file, IlluminantType ilumination, ObserverType observer, std::string output_directory);
@@ -86,6 +97,48 @@ namespace btrgb {
 
         int imageCount();
 
+        /**
+         * @brief Total number of pixels/bytes of every image that has been read
+         */
+        int64_t pixelCount();
+        int64_t byteCount();
+
+        /**
+         * @brief Attach the token of the process that owns this ArtObject
+         * Components use check_cancelled() to stop when the process is cancelled
+         */
+        void set_cancellation_token(std::shared_ptr<CancellationToken> token);
+        std::shared_ptr<CancellationToken> get_cancellation_token();
+
+        /**
+         * @brief Throws OperationCancelled if the owning process has been cancelled.
+         * Does nothing if no token has been attached.
+         */
+        void check_cancelled();
+
+        /**
+         * @brief Attach the trace of the run, spans are recorded to it.
+         * get_trace() returns nullptr if no trace has been attached, TraceSpan accepts that.
+         */
+        void set_trace(std::shared_ptr<Trace> trace);
+        Trace* get_trace();
+
+        /**
+         * @brief Build a new ArtObject containing only the color target region (plus a margin)
+         * of each image set. For each set the target image is cropped if one was provided, otherwise
+         * the art image. The matching white and dark images are cropped to the same region.
+         * Both sets are cropped to one region, so their target images must be the same size.
+         * The TargetData of the new ArtObject is renormalized to the cropped images.
+         * 
+         * This is meant for running a quick calibration preview so should be called after the images
+         * have been read and scaled but before any other processing.
+         * 
+         * @param margin the margin added around the target as a fraction of the target width/height
+         * @return std::unique_ptr<ArtObject> 
+         * @throws ArtObj_MismatchedSets if the target images of the two sets differ in size
+         */
+        std::unique_ptr<ArtObject> target_preview(double margin);
+
         void outputImageAs(enum output_type filetype, std::string name, std::string filename = "");
 
         /* Iterators over all image entries. */
@@ -115,6 +168,11 @@ namespace btrgb {
         virtual char const * what() const noexcept { return "ArtObject Error: No Verification Data Exists."; }
     };
 
+    class ArtObj_MismatchedSets : public ArtObjectError {
+        public:
+        virtual char const * what() const noexcept { return "ArtObject Error: The target images of both sets must be the same size."; }
+    };
+
 }
 
 
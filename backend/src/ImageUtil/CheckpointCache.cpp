@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <zlib.h>
+#include <jsoncons/json.hpp>
+
+#include "CheckpointCache.hpp"
+#include "utils/metrics.hpp"
+#include "utils/trace.hpp"
+
+namespace fs = std::filesystem;
+
+/* File layout
+ *
+ *  header      magic, format version, flags, offset and size of the metadata
+ *  image data  one block per image, each starting on a PAGE boundary.
+ *              Raw Mat data, or when compressed a series of [uint64 size][deflated CHUNK of raw data]
+ *  metadata    json describing each image (where its data is, type, exif...) and the stored results
+ */
+#define CHECKPOINT_MAGIC "BTRGBCKP"
+#define PAGE 4096
+#define CHUNK (64 * 1024 * 1024)
+#define FLAG_COMPRESSED 1
+
+namespace btrgb {
+
+    struct CheckpointHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t meta_offset;
+        uint64_t meta_size;
+    };
+
+    static void pad_to_page(std::ofstream& file) {
+        uint64_t pos = file.tellp();
+        uint64_t padding = (PAGE - pos % PAGE) % PAGE;
+        static const char zeros[PAGE] = {0};
+        file.write(zeros, padding);
+    }
+
+    CheckpointCache::CheckpointCache() {
+        this->directory = (fs::temp_directory_path() / "btrgb_checkpoints").string();
+    }
+
+    CheckpointCache* CheckpointCache::get_instance() {
+        static CheckpointCache instance;
+        return &instance;
+    }
+
+    void CheckpointCache::set_directory(std::string dir) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->directory = dir;
+    }
+
+    std::string CheckpointCache::get_directory() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->directory;
+    }
+
+    void CheckpointCache::set_size_limit(size_t bytes) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->size_limit = bytes;
+    }
+
+    void CheckpointCache::set_compression(bool enabled) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->compression = enabled;
+    }
+
+    bool CheckpointCache::enabled() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->size_limit > 0;
+    }
+
+    uint64_t CheckpointCache::hash(const void* data, size_t length, uint64_t seed) {
+        const uint8_t* bytes = (const uint8_t*) data;
+        uint64_t h = seed;
+        for (size_t i = 0; i < length; i++) {
+            h ^= bytes[i];
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+
+    uint64_t CheckpointCache::hash(std::string str, uint64_t seed) {
+        // The length goes in too so chained strings can't run into each other
+        uint64_t length = str.size();
+        seed = CheckpointCache::hash(&length, sizeof(length), seed);
+        return CheckpointCache::hash(str.data(), str.size(), seed);
+    }
+
+    uint64_t CheckpointCache::hash_file(std::string filename, uint64_t seed) {
+        uintmax_t size = fs::file_size(filename);
+        int64_t modified = fs::last_write_time(filename).time_since_epoch().count();
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            auto found = this->file_hashes.find(filename);
+            if (found != this->file_hashes.end() && found->second.size == size && found->second.modified == modified)
+                return CheckpointCache::hash(&found->second.hash, sizeof(uint64_t), seed);
+        }
+
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            throw CheckpointError("Failed to open " + filename);
+        uint64_t h = FNV_OFFSET;
+        std::vector<char> buffer(1024 * 1024);
+        while (file) {
+            file.read(buffer.data(), buffer.size());
+            h = CheckpointCache::hash(buffer.data(), file.gcount(), h);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->file_hashes[filename] = {size, modified, h};
+        }
+        return CheckpointCache::hash(&h, sizeof(uint64_t), seed);
+    }
+
+    std::string CheckpointCache::path(uint64_t key) {
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << CHECKPOINT_EXTENSION;
+        return (fs::path(this->get_directory()) / name.str()).string();
+    }
+
+    bool CheckpointCache::contains(uint64_t key) {
+        std::error_code ec;
+        return this->enabled() && fs::is_regular_file(this->path(key), ec);
+    }
+
+    void CheckpointCache::save(uint64_t key, ArtObject* images, const std::vector<std::string>& result_keys) {
+        bool compress;
+        size_t limit;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            compress = this->compression;
+            limit = this->size_limit;
+        }
+
+        // A checkpoint over the limit would be trimmed right after it is written, don't pay for the write.
+        // Raw size, deflate does little for float image data.
+        uint64_t estimate = sizeof(CheckpointHeader);
+        for (const auto& [name, im] : *images) {
+            cv::Mat m = im->getMat();
+            if (!m.empty())
+                estimate += PAGE + m.total() * m.elemSize();
+        }
+        if (estimate > limit) {
+            static Counter& too_large = Metrics::counter("checkpoints.tooLarge");
+            too_large.add();
+            throw CheckpointError("Checkpoint of " + std::to_string(estimate / (1024 * 1024)) +
+                " MB is larger than the cache limit of " + std::to_string(limit / (1024 * 1024)) + " MB");
+        }
+
+        std::string final_path = this->path(key);
+        // Unique per thread in case two runs write the same checkpoint
+        std::string tmp_path = final_path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        std::error_code ec;
+        fs::create_directories(this->get_directory(), ec);
+
+        TraceSpan span(images->get_trace(), "Save checkpoint", "io");
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw CheckpointError("Failed to create " + tmp_path);
+        int64_t total_bytes = 0;
+        try {
+            // Header is written last, once the metadata offset is known
+            CheckpointHeader header = {};
+            std::copy_n(CHECKPOINT_MAGIC, sizeof(header.magic), header.magic);
+            header.version = FORMAT_VERSION;
+            header.flags = compress ? FLAG_COMPRESSED : 0;
+            file.write((const char*) &header, sizeof(header));
+
+            jsoncons::json image_list = jsoncons::json::make_array();
+            std::vector<uint8_t> deflated;
+            for (const auto& [name, im] : *images) {
+                cv::Mat m = im->getMat();
+                if (m.empty())
+                    continue;
+                if (!m.isContinuous())
+                    m = m.clone();
+                images->check_cancelled();
+
+                pad_to_page(file);
+                uint64_t offset = file.tellp();
+                uint64_t length = m.total() * m.elemSize();
+                if (compress) {
+                    for (uint64_t pos = 0; pos < length; pos += CHUNK) {
+                        uLong chunk = (uLong) std::min<uint64_t>(CHUNK, length - pos);
+                        uLongf deflated_size = compressBound(chunk);
+                        deflated.resize(deflated_size);
+                        if (compress2(deflated.data(), &deflated_size, m.data + pos, chunk, Z_BEST_SPEED) != Z_OK)
+                            throw CheckpointError("Failed to compress " + name);
+                        uint64_t size = deflated_size;
+                        file.write((const char*) &size, sizeof(size));
+                        file.write((const char*) deflated.data(), deflated_size);
+                    }
+                }
+                else {
+                    file.write((const char*) m.data, length);
+                }
+                total_bytes += length;
+
+                exif tags = im->getExifTags();
+                jsoncons::json entry;
+                entry.insert_or_assign("key", name);
+                entry.insert_or_assign("name", im->getName());
+                entry.insert_or_assign("rows", m.rows);
+                entry.insert_or_assign("cols", m.cols);
+                entry.insert_or_assign("type", m.type());
+                entry.insert_or_assign("offset", offset);
+                entry.insert_or_assign("length", length);
+                entry.insert_or_assign("make", tags.make);
+                entry.insert_or_assign("model", tags.model);
+                entry.insert_or_assign("profile", (int) im->getColorProfile());
+                entry.insert_or_assign("bitDepth", (nullptr != im->_raw_bit_depth) ? *im->_raw_bit_depth : -1);
+                image_list.push_back(entry);
+            }
+
+            // Only results some stage stored are kept, the rest belong to the run
+            CalibrationResults* general = images->get_results_obj(ResultType::GENERAL);
+            jsoncons::json results;
+            for (const std::string& result_key : result_keys) {
+                try { results.insert_or_assign(result_key, general->get_string(result_key)); continue; } catch (const std::exception& e) {}
+                try { results.insert_or_assign(result_key, general->get_double(result_key)); } catch (const std::exception& e) {}
+            }
+
+            jsoncons::json meta;
+            meta.insert_or_assign("images", image_list);
+            meta.insert_or_assign("results", results);
+            std::string meta_str = meta.to_string();
+            header.meta_offset = file.tellp();
+            header.meta_size = meta_str.size();
+            file.write(meta_str.data(), meta_str.size());
+            file.seekp(0);
+            file.write((const char*) &header, sizeof(header));
+        }
+        catch (const std::exception& e) {
+            file.close();
+            fs::remove(tmp_path, ec);
+            if (nullptr != dynamic_cast<const OperationCancelled*>(&e) || nullptr != dynamic_cast<const CheckpointError*>(&e))
+                throw;
+            throw CheckpointError(e.what());
+        }
+        file.close();
+        if (file.fail()) {
+            fs::remove(tmp_path, ec);
+            throw CheckpointError("Failed to write " + tmp_path);
+        }
+
+        fs::rename(tmp_path, final_path, ec);
+        if (ec) {
+            fs::remove(tmp_path, ec);
+            throw CheckpointError("Failed to store " + final_path);
+        }
+        span.set_bytes(total_bytes);
+        this->trim();
+    }
+
+    bool CheckpointCache::load(uint64_t key, ArtObject* images) {
+        std::string file_path = this->path(key);
+        std::ifstream file(file_path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        // Whatever is wrong with it won't fix itself, removed so the stage runs and writes a new one
+        std::error_code ec;
+        auto invalid = [&]() {
+            file.close();
+            fs::remove(file_path, ec);
+            return false;
+        };
+
+        TraceSpan span(images->get_trace(), "Load checkpoint", "io");
+        CheckpointHeader header;
+        file.read((char*) &header, sizeof(header));
+        if (!file || !std::equal(header.magic, header.magic + sizeof(header.magic), CHECKPOINT_MAGIC) || header.version != FORMAT_VERSION || header.meta_size > CHUNK)
+            return invalid();
+
+        std::string meta_str(header.meta_size, '\0');
+        file.seekg(header.meta_offset);
+        file.read(meta_str.data(), header.meta_size);
+        if (!file)
+            return invalid();
+
+        struct Loaded {
+            std::string key;
+            std::string name;
+            cv::Mat mat;
+            exif tags;
+            int profile;
+            int bit_depth;
+        };
+        std::vector<Loaded> loaded;
+        jsoncons::json results;
+        int64_t total_bytes = 0;
+        try {
+            jsoncons::json meta = jsoncons::json::parse(meta_str);
+            results = meta.at("results");
+            std::vector<uint8_t> deflated;
+            for (const auto& entry : meta.at("images").array_range()) {
+                images->check_cancelled();
+                Loaded im;
+                im.key = entry.at("key").as<std::string>();
+                im.name = entry.at("name").as<std::string>();
+                im.tags.make = entry.at("make").as<std::string>();
+                im.tags.model = entry.at("model").as<std::string>();
+                im.profile = entry.at("profile").as<int>();
+                im.bit_depth = entry.at("bitDepth").as<int>();
+                im.mat.create(entry.at("rows").as<int>(), entry.at("cols").as<int>(), entry.at("type").as<int>());
+                uint64_t length = entry.at("length").as<uint64_t>();
+                if (length != im.mat.total() * im.mat.elemSize())
+                    return invalid();
+
+                file.seekg(entry.at("offset").as<uint64_t>());
+                if (header.flags & FLAG_COMPRESSED) {
+                    for (uint64_t pos = 0; pos < length; pos += CHUNK) {
+                        uLongf chunk = (uLongf) std::min<uint64_t>(CHUNK, length - pos);
+                        uint64_t size = 0;
+                        file.read((char*) &size, sizeof(size));
+                        if (!file || size > compressBound(chunk))
+                            return invalid();
+                        deflated.resize(size);
+                        file.read((char*) deflated.data(), size);
+                        uLongf expected = chunk;
+                        if (!file || uncompress(im.mat.data + pos, &chunk, deflated.data(), size) != Z_OK || chunk != expected)
+                            return invalid();
+                    }
+                }
+                else {
+                    file.read((char*) im.mat.data, length);
+                }
+                if (!file)
+                    return invalid();
+                total_bytes += length;
+                loaded.push_back(std::move(im));
+            }
+        }
+        catch (const OperationCancelled& e) {
+            throw;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Corrupt checkpoint " << file_path << ": " << e.what() << std::endl;
+            return invalid();
+        }
+        file.close();
+
+        // Everything read, now the ArtObject can be changed
+        std::vector<std::string> stale;
+        for (const auto& [name, im] : *images) {
+            if (std::none_of(loaded.begin(), loaded.end(), [&](const Loaded& l) { return l.key == name; }))
+                stale.push_back(name);
+        }
+        for (const std::string& name : stale)
+            images->deleteImage(name);
+
+        for (Loaded& l : loaded) {
+            if (!images->imageExists(l.key))
+                images->setImage(l.key, new Image(l.name));
+            Image* im = images->getImage(l.key);
+            im->initImage(l.mat);
+            im->setExifTags(l.tags);
+            im->setColorProfile((ColorSpace) l.profile);
+            im->_raw_bit_depth = std::shared_ptr<int>(new int(l.bit_depth));
+        }
+
+        CalibrationResults* general = images->get_results_obj(ResultType::GENERAL);
+        for (const auto& result : results.object_range()) {
+            if (result.value().is_string())
+                general->store_string(std::string(result.key()), result.value().as<std::string>());
+            else
+                general->store_double(std::string(result.key()), result.value().as<double>());
+        }
+
+        // Recently used checkpoints are the last to be trimmed
+        fs::last_write_time(file_path, fs::file_time_type::clock::now(), ec);
+        span.set_bytes(total_bytes);
+        return true;
+    }
+
+    void CheckpointCache::trim() {
+        size_t limit;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            limit = this->size_limit;
+        }
+
+        std::error_code ec;
+        std::vector<fs::directory_entry> checkpoints;
+        uintmax_t total = 0;
+        for (const fs::directory_entry& entry : fs::directory_iterator(this->get_directory(), ec)) {
+            if (entry.path().extension() != CHECKPOINT_EXTENSION || !entry.is_regular_file(ec))
+                continue;
+            checkpoints.push_back(entry);
+            total += entry.file_size(ec);
+        }
+
+        std::sort(checkpoints.begin(), checkpoints.end(), [&](const fs::directory_entry& a, const fs::directory_entry& b) {
+            return a.last_write_time(ec) < b.last_write_time(ec);
+        });
+        for (const fs::directory_entry& entry : checkpoints) {
+            if (total <= limit)
+                break;
+            uintmax_t size = entry.file_size(ec);
+            if (fs::remove(entry.path(), ec))
+                total -= size;
+        }
+    }
+
+}
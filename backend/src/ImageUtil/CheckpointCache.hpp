@@ -0,0 +1,117 @@
+#ifndef BTRGB_CHECKPOINT_CACHE_HPP
+#define BTRGB_CHECKPOINT_CACHE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ImageUtil/ArtObject.hpp"
+
+#define CHECKPOINT_EXTENSION ".btrgbck"
+
+namespace btrgb {
+
+    /**
+     * @brief On-disk cache of the images (and the results that go with them) as they were after
+     * an expensive pipeline stage, so a re-run with the same inputs can start from there.
+     *
+     * Checkpoints are content addressed: the key is a hash of the contents of every input file plus every
+     * setting the stages up to the checkpoint depend on, so a checkpoint can never be stale. Changing a
+     * setting just changes the key of that stage and every one after it.
+     *
+     * Each checkpoint is one file named after its key. Image data is stored raw at page aligned offsets
+     * so the file can be mapped, or deflated in chunks when compression is enabled. Files are written
+     * under a temporary name and renamed once complete, and the least recently used ones are removed
+     * when the cache grows over its size limit.
+     */
+    class CheckpointCache {
+        public:
+            // Bump whenever a cached stage changes what it produces so old checkpoints stop matching
+            static const uint32_t FORMAT_VERSION = 1;
+            static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+            static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+            static CheckpointCache* get_instance();
+
+            /**
+             * @brief Set where checkpoints are stored, the directory is created if needed
+             */
+            void set_directory(std::string dir);
+            std::string get_directory();
+
+            /**
+             * @brief Set the most bytes of checkpoints to keep, 0 disables the cache
+             */
+            void set_size_limit(size_t bytes);
+            void set_compression(bool enabled);
+            bool enabled();
+
+            /**
+             * @brief 64 bit FNV-1a hash
+             *
+             * @param seed the hash to continue from, used to chain values into one key
+             */
+            static uint64_t hash(const void* data, size_t length, uint64_t seed = FNV_OFFSET);
+            static uint64_t hash(std::string str, uint64_t seed = FNV_OFFSET);
+
+            /**
+             * @brief Hash of the contents of a file chained onto seed
+             * The content hash is remembered for as long as the file's size and modification time don't change.
+             */
+            uint64_t hash_file(std::string filename, uint64_t seed = FNV_OFFSET);
+
+            /**
+             * @brief Check if a complete checkpoint exists for the key
+             */
+            bool contains(uint64_t key);
+
+            /**
+             * @brief Store every initialized image of the ArtObject, along with the given general results
+             * @throws CheckpointError if the checkpoint couldn't be written, or wouldn't fit in the size limit
+             */
+            void save(uint64_t key, ArtObject* images, const std::vector<std::string>& result_keys);
+
+            /**
+             * @brief Replace the images of the ArtObject with the ones of the checkpoint and restore its results
+             * Images not in the checkpoint are deleted from the ArtObject.
+             * @return false if the checkpoint is missing or unreadable, the ArtObject is left untouched
+             */
+            bool load(uint64_t key, ArtObject* images);
+
+            /**
+             * @brief Remove the least recently used checkpoints until the cache fits in its size limit
+             */
+            void trim();
+
+        private:
+            CheckpointCache();
+            std::string path(uint64_t key);
+
+            struct FileHash {
+                uintmax_t size;
+                int64_t modified;
+                uint64_t hash;
+            };
+
+            std::mutex mutex;
+            std::string directory;
+            size_t size_limit = 0;
+            bool compression = false;
+            std::unordered_map<std::string, FileHash> file_hashes;
+    };
+
+    class CheckpointError : public std::exception {
+        private:
+            std::string msg;
+        public:
+            CheckpointError(std::string msg) {
+                this->msg = "[CheckpointCache] " + msg;
+            }
+            virtual char const * what() const noexcept { return  this->msg.c_str(); }
+    };
+
+}
+
+#endif
@@ -1,5 +1,11 @@
 #include "ColorProfiles.hpp"
 
+/* Transfer functions of the supported color spaces, for values in [0, 1]. */
+#define BTRGB_PROPHOTO_INVERSE_GAMMA(x) (x >= 0.03125 ? pow(x, 1.8) : x / 16)
+#define BTRGB_sRGB_INVERSE_GAMMA(x) (x > 0.040449936 ? pow((x + 0.055) / 1.055, 2.4): x / 12.92)
+#define BTRGB_PROPHOTO_GAMMA(x) (x >= 0.001953125 ? pow(x, 1/1.8) : x * 16)
+#define BTRGB_sRGB_GAMMA(x) (x > 0.0031308 ? 1.055 * pow(x, 1/2.4) - 0.055 : x * 12.92)
+
 namespace btrgb {
 
 
@@ -83,7 +89,7 @@ void ColorProfiles::multiply_conversion_matrix(cv::Mat im, cv::Mat m) {
 }
 
 
-void ColorProfiles::convert_to_xyz(cv::Mat im, ColorSpace from) {
+cv::Mat ColorProfiles::xyz_matrix(ColorSpace from) {
     cv::Mat m;
 
     switch(from) {
@@ -119,11 +125,16 @@ void ColorProfiles::convert_to_xyz(cv::Mat im, ColorSpace from) {
         throw std::runtime_error("[ColorProfiles::convert_to_xyz] Not implemented. ");
     }
 
-    ColorProfiles::multiply_conversion_matrix(im, m);
+    return m;
 }
 
 
-void ColorProfiles::convert_to_color(cv::Mat im, ColorSpace to) {
+void ColorProfiles::convert_to_xyz(cv::Mat im, ColorSpace from) {
+    ColorProfiles::multiply_conversion_matrix(im, ColorProfiles::xyz_matrix(from));
+}
+
+
+cv::Mat ColorProfiles::color_matrix(ColorSpace to) {
     cv::Mat m;
 
     switch(to) {
@@ -159,7 +170,12 @@ void ColorProfiles::convert_to_color(cv::Mat im, ColorSpace to) {
         throw std::runtime_error("[ColorProfiles::convert_to_color] Not implemented. ");
     }
 
-    ColorProfiles::multiply_conversion_matrix(im, m);
+    return m;
+}
+
+
+void ColorProfiles::convert_to_color(cv::Mat im, ColorSpace to) {
+    ColorProfiles::multiply_conversion_matrix(im, ColorProfiles::color_matrix(to));
 
     #define BTRGB_CLIP_PIXEL(x) (x < 0 ? 0 : (x > 1 ? 1 : x))
     im.forEach<cv::Vec3f>([](cv::Vec3f& pixel, const int* pos) -> void {
@@ -172,9 +188,6 @@ void ColorProfiles::convert_to_color(cv::Mat im, ColorSpace to) {
 
 
 void ColorProfiles::linearize(cv::Mat im, ColorSpace from) {
-    #define BTRGB_PROPHOTO_INVERSE_GAMMA(x) (x >= 0.03125 ? pow(x, 1.8) : x / 16)
-    #define BTRGB_sRGB_INVERSE_GAMMA(x) (x > 0.040449936 ? pow((x + 0.055) / 1.055, 2.4): x / 12.92)
-
     switch(from) {
 
         case ColorSpace::ProPhoto:
@@ -194,16 +207,10 @@ void ColorProfiles::linearize(cv::Mat im, ColorSpace from) {
         default:
             throw std::runtime_error("[ColorProfiles::inverse_gamma] Not implemented. ");
     }
-        
-    #undef BTRGB_PROPHOTO_INVERSE_GAMMA
-    #undef BTRGB_sRGB_INVERSE_GAMMA
 }
 
 
 void ColorProfiles::apply_gamma(cv::Mat im, ColorSpace to) {
-    #define BTRGB_PROPHOTO_GAMMA(x) (x >= 0.001953125 ? pow(x, 1/1.8) : x * 16)
-    #define BTRGB_sRGB_GAMMA(x) (x > 0.0031308 ? 1.055 * pow(x, 1/2.4) - 0.055 : x * 12.92)
-
     int channels = im.channels();
     switch(to) {
 
@@ -224,9 +231,27 @@ void ColorProfiles::apply_gamma(cv::Mat im, ColorSpace to) {
         default:
             throw std::runtime_error("[ColorProfiles::apply_gamma] Not implemented. ");
     }
-    
-    #undef BTRGB_PROPHOTO_GAMMA
-    #undef BTRGB_sRGB_GAMMA
+}
+
+
+
+float ColorProfiles::inverse_gamma(float x, ColorSpace from) {
+    switch(from) {
+        case ColorSpace::ProPhoto: return BTRGB_PROPHOTO_INVERSE_GAMMA(x);
+        case ColorSpace::sRGB: return BTRGB_sRGB_INVERSE_GAMMA(x);
+        default:
+            throw std::runtime_error("[ColorProfiles::inverse_gamma] Not implemented. ");
+    }
+}
+
+
+float ColorProfiles::gamma(float x, ColorSpace to) {
+    switch(to) {
+        case ColorSpace::ProPhoto: return BTRGB_PROPHOTO_GAMMA(x);
+        case ColorSpace::sRGB: return BTRGB_sRGB_GAMMA(x);
+        default:
+            throw std::runtime_error("[ColorProfiles::apply_gamma] Not implemented. ");
+    }
 }
 
 
@@ -35,6 +35,14 @@ public:
     /* Modifies an image by multiplying it by the given conversion matrix m. */
     static void multiply_conversion_matrix(cv::Mat im, cv::Mat m);
 
+    /* The 3x3 float matrices used by convert_to_xyz and convert_to_color. */
+    static cv::Mat xyz_matrix(ColorSpace from);
+    static cv::Mat color_matrix(ColorSpace to);
+
+    /* linearize and apply_gamma for a single value. */
+    static float inverse_gamma(float x, ColorSpace from);
+    static float gamma(float x, ColorSpace to);
+
 private:
 
     /* Channel constants. */
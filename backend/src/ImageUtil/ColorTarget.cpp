@@ -1,4 +1,6 @@
 #include "ColorTarget.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
 
 ColorTarget::ColorTarget(btrgb::Image* im, TargetData location_data, RefData* ref_data) {
 	this->im = im;
@@ -26,6 +28,8 @@ ColorTarget::ColorTarget(btrgb::Image* im, TargetData location_data, RefData* re
 	this->col_width = this->target_width / this->col_count;
 	// Init sampel size
 	this->sample_size = location_data.sample_size;
+	this->statistic = location_data.statistic;
+	this->trim_fraction = location_data.trim_fraction;
 	// White Patch Init
 	// The TargetData has already subtraced one so this is already zero based
 	this->white_row = location_data.w_row;
@@ -58,31 +62,130 @@ ColorTarget::ColorTarget(btrgb::Image* im, TargetData location_data, RefData* re
 *
 */
 float ColorTarget::get_patch_avg(int row, int col, int chan) {
-	int center_pixX = this->patch_posX(col);
-	int center_pixY = this->patch_posY(row);
-	// The sample_size is the size of the sample to take from a color patch as a percentage of the patch size
-	// Sample width/height
-	int sw = this->sample_size * this->col_width;
-	// Sample radious(number of pixels on either side of center)
-	int sr = (sw - 1) / 2;
+	cv::Rect sample = this->sample_rect(row, col);
 
 	// Find sume of pixel values for all pixels within sample
 	float pixel_value_sum = 0;
-	for (int yOffset = -sr; yOffset < sr + 1; yOffset++) {
-		for (int xOffset = -sr; xOffset < sr + 1; xOffset++) {
-			int col = center_pixX + xOffset;
-			int row = center_pixY + yOffset;
-			pixel_value_sum += im->getPixel(row, col, chan);
-			//std::cout << "pixel(" << col << "," << row << "): " << im->getPixel(row, col, chan) << std::endl;
+	std::shared_ptr<btrgb::PatchStatistics> stats = this->get_statistics(sample);
+	if (stats != nullptr) {
+		pixel_value_sum = stats->sum(sample, chan);
+	}
+	else {
+		// Sample hangs off the image, sum it up the slow way
+		for (int y = sample.y; y < sample.y + sample.height; y++) {
+			for (int x = sample.x; x < sample.x + sample.width; x++) {
+				pixel_value_sum += im->getPixel(y, x, chan);
+			}
 		}
 	}
 
-	// The sample pixels form a square so the number of pixels is sample_width squared
-	int pixel_count = pow(sw, 2);
+	// The sample pixels form a square of 2sr + 1 pixels a side, one less than sw when sw is even
+	int pixel_count = sample.area();
 	float avg = pixel_value_sum / pixel_count;
 	return avg;
 }
 
+float ColorTarget::get_patch_variance(int row, int col, int chan) {
+	cv::Rect sample = this->sample_rect(row, col);
+	std::shared_ptr<btrgb::PatchStatistics> stats = this->get_statistics(sample);
+	if (stats != nullptr)
+		return stats->variance(sample, chan);
+
+	double sum = 0;
+	double sq_sum = 0;
+	for (int y = sample.y; y < sample.y + sample.height; y++) {
+		for (int x = sample.x; x < sample.x + sample.width; x++) {
+			double value = im->getPixel(y, x, chan);
+			sum += value;
+			sq_sum += value * value;
+		}
+	}
+	double n = sample.area();
+	double mean = sum / n;
+	double var = sq_sum / n - mean * mean;
+	return var < 0 ? 0 : var;
+}
+
+std::vector<PatchStats> ColorTarget::get_all_patch_stats(int channel_count) {
+	int patch_count = this->row_count * this->col_count;
+	std::vector<PatchStats> stats(patch_count * channel_count);
+
+	// Build the summed area tables up front so the workers only ever read the cached tables
+	cv::Rect all_samples(this->target_left_edge, this->target_top_edge, this->target_width, this->target_height);
+	for (int patch = 0; patch < patch_count; patch++)
+		all_samples |= this->sample_rect(patch / this->col_count, patch % this->col_count);
+	this->im->getPatchStatistics(all_samples);
+
+	btrgb::ThreadPool::get_instance()->parallel_for(0, patch_count, [&](int start, int end) {
+		std::vector<float> values;
+		for (int patch = start; patch < end; patch++) {
+			int row = patch / this->col_count;
+			int col = patch % this->col_count;
+			cv::Rect sample = this->sample_rect(row, col);
+			for (int chan = 0; chan < channel_count; chan++) {
+				PatchStats& s = stats[patch * channel_count + chan];
+				s.mean = this->get_patch_avg(row, col, chan);
+				s.std_dev = sqrt(this->get_patch_variance(row, col, chan));
+				s.median = s.mean;
+				s.trimmed_mean = s.mean;
+				if (this->statistic == PATCH_MEAN)
+					continue;
+
+				// Order statistics need the actual values
+				values.clear();
+				for (int y = sample.y; y < sample.y + sample.height; y++)
+					for (int x = sample.x; x < sample.x + sample.width; x++)
+						values.push_back(im->getPixel(y, x, chan));
+				std::sort(values.begin(), values.end());
+
+				int n = values.size();
+				if (n % 2 == 1)
+					s.median = values[n / 2];
+				else
+					s.median = (values[n / 2 - 1] + values[n / 2]) / 2;
+
+				// Drop the lowest and highest trim_fraction of the values (dust, specular hits)
+				// trim_fraction is below 0.5 (checked when parsed) so at least one value is left
+				int trim = n * this->trim_fraction;
+				double trimmed_sum = 0;
+				for (int i = trim; i < n - trim; i++)
+					trimmed_sum += values[i];
+				s.trimmed_mean = trimmed_sum / (n - 2 * trim);
+			}
+		}
+	});
+	return stats;
+}
+
+PatchStatistic ColorTarget::get_statistic() {
+	return this->statistic;
+}
+
+float ColorTarget::select_statistic(PatchStats stats) {
+	switch (this->statistic) {
+		case PATCH_MEDIAN: return stats.median;
+		case PATCH_TRIMMED_MEAN: return stats.trimmed_mean;
+		default: return stats.mean;
+	}
+}
+
+cv::Rect ColorTarget::sample_rect(int row, int col) {
+	int center_pixX = this->patch_posX(col);
+	int center_pixY = this->patch_posY(row);
+	int sw = this->sample_size * this->col_width;
+	// Sample radious(number of pixels on either side of center)
+	int sr = (sw - 1) / 2;
+	return cv::Rect(center_pixX - sr, center_pixY - sr, 2 * sr + 1, 2 * sr + 1);
+}
+
+std::shared_ptr<btrgb::PatchStatistics> ColorTarget::get_statistics(cv::Rect sample) {
+	cv::Rect target_area(this->target_left_edge, this->target_top_edge, this->target_width, this->target_height);
+	std::shared_ptr<btrgb::PatchStatistics> stats = this->im->getPatchStatistics(target_area | sample);
+	if (!stats->covers(sample))
+		return nullptr;
+	return stats;
+}
+
 int ColorTarget::patch_posX(int col) {
 	int col_width = this->target_width / this->col_count;
 	int offset = col * col_width;
@@ -5,6 +5,26 @@
 #include "reference_data/ref_data.hpp"
 #include <iostream>
 #include <math.h>
+#include <vector>
+
+/**
+ * @brief The statistic used as the value of a color patch
+ */
+enum PatchStatistic {
+	PATCH_MEAN,
+	PATCH_MEDIAN,
+	PATCH_TRIMMED_MEAN
+};
+
+/**
+ * @brief Statistics for the sample of one channel of one color patch
+ */
+typedef struct patch_stats {
+	float mean;
+	float std_dev;
+	float median;
+	float trimmed_mean;
+}PatchStats;
 
 typedef struct target_location {
 	// Normalized locations of the four edges of the Target
@@ -19,6 +39,9 @@ typedef struct target_location {
 	// Ref Data
 	std::string ref_base, illum_base;
 	int obsv_base;
+	// Statistic used for patch values and the fraction trimmed off each end for PATCH_TRIMMED_MEAN
+	PatchStatistic statistic = PATCH_MEAN;
+	double trim_fraction = 0.1;
 }TargetData;
 
 /**
@@ -45,6 +68,42 @@ public:
 	 */
 	float get_patch_avg(int row, int col, int channel);
 
+	/**
+	 * @brief Calculate the variance of the pixel values for specified color patch
+	 *
+	 * @param row the row of the color patch
+	 * @param col the col of the color patch
+	 * @param channel the color channel
+	 * @return float the variance of the sample
+	 */
+	float get_patch_variance(int row, int col, int channel);
+
+	/**
+	 * @brief Calculate the mean, standard deviation, median and trimmed mean of every
+	 * channel of every color patch. Each patch is handled by its own worker.
+	 * The median and trimmed mean are only computed if they are this target's statistic,
+	 * otherwise they are set to the mean.
+	 *
+	 * @param channel_count the number of channels to compute stats for
+	 * @return std::vector<PatchStats> indexed by (row * col_count + col) * channel_count + channel
+	 */
+	std::vector<PatchStats> get_all_patch_stats(int channel_count);
+
+	/**
+	 * @brief Get the statistic this target uses as the value of a color patch
+	 *
+	 * @return PatchStatistic
+	 */
+	PatchStatistic get_statistic();
+
+	/**
+	 * @brief Pick this targets statistic out of a PatchStats
+	 *
+	 * @param stats
+	 * @return float
+	 */
+	float select_statistic(PatchStats stats);
+
 	/**
 	 * @brief Get the row count
 	 *
@@ -86,6 +145,9 @@ private:
 	RefData* ref_data;
 	// Size of the sample to take from a color patch as a percentage of the patch size
 	double sample_size = 0.3;
+	// Statistic used as a patch value
+	PatchStatistic statistic = PATCH_MEAN;
+	double trim_fraction = 0.1;
 
 	/**
 	 * @brief Calculate the center x postiton for the specified col
@@ -103,6 +165,24 @@ private:
 	 */
 	int patch_posY(int row);
 
+	/**
+	 * @brief The square sample area for the specified patch in image coordinates
+	 *
+	 * @param row
+	 * @param col
+	 * @return cv::Rect
+	 */
+	cv::Rect sample_rect(int row, int col);
+
+	/**
+	 * @brief Summed area tables for the target area of the image
+	 * These are cached on the image so every ColorTarget for the same image shares them
+	 *
+	 * @param sample the sample that must be covered
+	 * @return std::shared_ptr<btrgb::PatchStatistics> or nullptr if the sample can not be covered
+	 */
+	std::shared_ptr<btrgb::PatchStatistics> get_statistics(cv::Rect sample);
+
 
 };
 
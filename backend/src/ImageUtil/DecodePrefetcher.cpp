@@ -0,0 +1,104 @@
+#include <algorithm>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "DecodePrefetcher.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "utils/metrics.hpp"
+
+namespace btrgb {
+
+    DecodePrefetcher* DecodePrefetcher::get_instance() {
+        static DecodePrefetcher instance;
+        return &instance;
+    }
+
+    DecodePrefetcher::~DecodePrefetcher() {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->changed.notify_all();
+        if (this->worker.joinable())
+            this->worker.join();
+    }
+
+    void DecodePrefetcher::set_memory_limit(size_t bytes) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->memory_limit = bytes;
+        if (bytes == 0)
+            this->queued.clear();
+    }
+
+    bool DecodePrefetcher::enabled() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->memory_limit > 0 && DecodedImageCache::get_instance()->enabled();
+    }
+
+    void DecodePrefetcher::prefetch(std::vector<std::string> files) {
+        if (!this->enabled())
+            return;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (this->stopping)
+            return;
+
+        // The newest request is the most likely to be processed next, its files go first in their own order
+        this->batch_bytes = 0;
+        for (auto it = files.rbegin(); it != files.rend(); it++) {
+            std::string filename = *it;
+            std::erase(this->queued, filename);
+            this->queued.push_front(filename);
+        }
+
+        if (!this->worker.joinable())
+            this->worker = std::thread(&DecodePrefetcher::work, this);
+        this->changed.notify_all();
+    }
+
+    void DecodePrefetcher::work() {
+        static Counter& decoded = Metrics::counter("prefetch.decoded");
+        static Counter& skipped = Metrics::counter("prefetch.skipped");
+        DecodedImageCache* cache = DecodedImageCache::get_instance();
+#ifdef _OPENMP
+        // Background work, LibRaw gets one core at most
+        omp_set_num_threads(1);
+#endif
+        while (true) {
+            std::string filename;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->changed.wait(lock, [this]() { return this->stopping || !this->queued.empty(); });
+                if (this->stopping)
+                    return;
+
+                // Decoding more would only evict files of the same request
+                if (this->batch_bytes >= std::min(this->memory_limit, cache->memory_limit())) {
+                    skipped.add(this->queued.size());
+                    this->queued.clear();
+                    continue;
+                }
+                filename = this->queued.front();
+                this->queued.pop_front();
+            }
+
+            size_t bytes = 0;
+            try {
+                // The same decode ImageReader does for a full resolution read
+                std::shared_ptr<const DecodedImage> image = cache->get(filename, DecodedImageCache::FULL);
+                image->bit_depth();
+                bytes = image->bitmap.total() * image->bitmap.elemSize();
+                decoded.add();
+            }
+            catch (...) {
+                // ImageReader will run into the same problem and report it
+            }
+
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->batch_bytes += bytes;
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef BTRGB_DECODE_PREFETCHER_HPP
+#define BTRGB_DECODE_PREFETCHER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace btrgb {
+
+    /**
+     * @brief Decodes files in the background ahead of the request that will need them
+     *
+     * The frontend shows previews (Thumbnails, HalfSizePreview) of the exact files it later submits for
+     * processing, so when previews are requested the same files are queued here for a full decode, the
+     * one ImageReader does (unprocessed raw data, or the whole TIFF), along with their bit depth.
+     * The results go in the DecodedImageCache where ImageReader finds them. A file ImageReader asks for
+     * while it is being decoded here is waited for rather than decoded twice.
+     *
+     * Decoding runs on a single background thread so it never takes more than one core from the requests
+     * that are running. Files of the newest preview request go first, and a request stops being prefetched
+     * once its files use up the memory limit (or the cache's limit, if lower) so they don't evict each other.
+     *
+     * To use
+     *      DecodePrefetcher::get_instance()->prefetch(files);
+     */
+    class DecodePrefetcher {
+        public:
+            static DecodePrefetcher* get_instance();
+            ~DecodePrefetcher();
+
+            /**
+             * @brief Set the most bytes of decoded images to prefetch for one request, 0 disables prefetching
+             */
+            void set_memory_limit(size_t bytes);
+            bool enabled();
+
+            /**
+             * @brief Queue files to be decoded, ahead of any files queued before
+             */
+            void prefetch(std::vector<std::string> files);
+
+        private:
+            DecodePrefetcher() {}
+            void work();
+
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::thread worker;
+            bool stopping = false;
+            size_t memory_limit = 0;
+            // Bytes decoded since the last prefetch() call
+            size_t batch_bytes = 0;
+            std::deque<std::string> queued;
+    };
+
+}
+
+#endif
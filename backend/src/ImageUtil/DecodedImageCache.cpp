@@ -0,0 +1,285 @@
+#include <filesystem>
+
+#include "DecodedImageCache.hpp"
+#include "ImageUtil/Image.hpp"
+#include "ImageUtil/BitDepthFinder.hpp"
+#include "ImageUtil/ImageReader/LibRawReader.hpp"
+#include "ImageUtil/ImageReader/LibTiffReader.hpp"
+#include "utils/memory_tracker.hpp"
+#include "utils/metrics.hpp"
+
+namespace fs = std::filesystem;
+
+namespace btrgb {
+
+    /* ============[ DecodedImage ]============== */
+
+    int DecodedImage::bit_depth() const {
+        std::call_once(this->bit_depth_once, [this]() {
+            if (this->bitmap.depth() != CV_16U)
+                return;
+            BitDepthFinder finder;
+            this->found_bit_depth = finder.get_bit_depth(
+                (uint16_t*) this->bitmap.data,
+                this->bitmap.cols,
+                this->bitmap.rows,
+                this->bitmap.channels()
+            );
+        });
+        return this->found_bit_depth;
+    }
+
+    /* ============[ DecodedImageCache ]============== */
+
+    DecodedImageCache* DecodedImageCache::get_instance() {
+        static DecodedImageCache instance;
+        return &instance;
+    }
+
+    void DecodedImageCache::set_memory_limit(size_t bytes) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->limit = bytes;
+        this->evict(0);
+    }
+
+    size_t DecodedImageCache::memory_limit() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->limit;
+    }
+
+    bool DecodedImageCache::enabled() {
+        return this->memory_limit() > 0;
+    }
+
+    size_t DecodedImageCache::bytes() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->held_bytes;
+    }
+
+    int DecodedImageCache::entry_count() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->entries.size();
+    }
+
+    std::shared_ptr<const DecodedImage> DecodedImageCache::get(std::string filename, Mode mode, ImageReaderStrategy* reader) {
+        static Counter& hits = Metrics::counter("decodeCache.hits");
+        static Counter& misses = Metrics::counter("decodeCache.misses");
+
+        bool tiff = Image::is_tiff(filename);
+        if (tiff)
+            mode = FULL;
+        const char* mode_names[] = {"full", "draft", "preview"};
+        std::string k = key(filename, mode_names[mode]);
+
+        if (!k.empty()) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->begin_load(lock, k);
+            Entry entry;
+            if (this->lookup(k, entry) && nullptr != entry.image) {
+                this->loading.erase(k);
+                lock.unlock();
+                this->loaded.notify_all();
+                hits.add();
+                return entry.image;
+            }
+        }
+        misses.add();
+
+        std::shared_ptr<DecodedImage> image(new DecodedImage);
+        std::unique_ptr<ImageReaderStrategy> own_reader;
+        if (nullptr == reader) {
+            if (tiff)
+                own_reader.reset(new LibTiffReader);
+            else if (mode == DRAFT)
+                own_reader.reset(new LibRawReader(LibRawReader::DRAFT));
+            else if (mode == PREVIEW)
+                own_reader.reset(new LibRawReader(LibRawReader::PREVIEW));
+            else
+                own_reader.reset(new LibRawReader(LibRawReader::UNPROCESSED));
+            reader = own_reader.get();
+        }
+
+        try {
+            // The bitmap belongs to the cache, not to the request that happened to decode it first
+            MemoryAccount::Bind unbind(nullptr);
+            reader->open(filename);
+            reader->copyBitmapTo(image->bitmap);
+            image->tags = reader->getExifData();
+            reader->recycle();
+        }
+        catch (...) {
+            reader->recycle();
+            if (!k.empty())
+                this->end_load(k);
+            throw;
+        }
+
+        if (!k.empty()) {
+            Entry entry;
+            entry.key = k;
+            entry.image = image;
+            entry.bytes = image->bitmap.total() * image->bitmap.elemSize();
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->insert(entry);
+            this->loading.erase(k);
+            lock.unlock();
+            this->loaded.notify_all();
+        }
+        return image;
+    }
+
+    std::shared_ptr<const DecodedImage> DecodedImageCache::find(std::string filename, Mode mode) {
+        if (Image::is_tiff(filename))
+            mode = FULL;
+        const char* mode_names[] = {"full", "draft", "preview"};
+        std::string k = key(filename, mode_names[mode]);
+        if (k.empty())
+            return nullptr;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        Entry entry;
+        if (!this->lookup(k, entry))
+            return nullptr;
+        return entry.image;
+    }
+
+    std::shared_ptr<const TiffMetadata> DecodedImageCache::metadata(std::string filename) {
+        static Counter& hits = Metrics::counter("tiffMetadata.hits");
+        static Counter& misses = Metrics::counter("tiffMetadata.misses");
+
+        std::string k = key(filename, "metadata");
+        if (!k.empty()) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->begin_load(lock, k);
+            Entry entry;
+            if (this->lookup(k, entry) && nullptr != entry.metadata) {
+                this->loading.erase(k);
+                lock.unlock();
+                this->loaded.notify_all();
+                hits.add();
+                return entry.metadata;
+            }
+        }
+        misses.add();
+
+        std::shared_ptr<TiffMetadata> metadata(new TiffMetadata);
+        size_t bytes = sizeof(TiffMetadata);
+        try {
+            LibTiffReader reader;
+            reader.open(filename);
+            metadata->width = reader.width();
+            metadata->height = reader.height();
+            metadata->channels = reader.channels();
+            metadata->depth = reader.depth();
+
+            try {
+                void* profile;
+                uint32_t profile_size;
+                reader.getColorProfile(&profile_size, &profile);
+                metadata->color_profile.assign((uint8_t*) profile, (uint8_t*) profile + profile_size);
+                bytes += profile_size;
+            } catch(const std::exception& e) {}
+
+            try {
+                metadata->conversion_matrices = reader.getConversionMatrices();
+                for (const auto& [name, m] : metadata->conversion_matrices)
+                    bytes += name.size() + m.total() * m.elemSize();
+            } catch(const std::exception& e) {}
+
+            reader.recycle();
+        }
+        catch (...) {
+            if (!k.empty())
+                this->end_load(k);
+            throw;
+        }
+
+        if (!k.empty()) {
+            Entry entry;
+            entry.key = k;
+            entry.metadata = metadata;
+            entry.bytes = bytes;
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->insert(entry);
+            this->loading.erase(k);
+            lock.unlock();
+            this->loaded.notify_all();
+        }
+        return metadata;
+    }
+
+    std::string DecodedImageCache::key(std::string filename, std::string kind) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(filename, ec);
+        if (ec)
+            return "";
+        int64_t modified = fs::last_write_time(filename, ec).time_since_epoch().count();
+        if (ec)
+            return "";
+        return kind + "|" + std::to_string(size) + "|" + std::to_string(modified) + "|" + filename;
+    }
+
+    bool DecodedImageCache::lookup(std::string key, Entry& entry) {
+        auto found = this->index.find(key);
+        if (found == this->index.end())
+            return false;
+        // Move to the front, it is now the most recently used
+        this->entries.splice(this->entries.begin(), this->entries, found->second);
+        entry = *found->second;
+        return true;
+    }
+
+    void DecodedImageCache::insert(Entry entry) {
+        static Counter& too_large = Metrics::counter("decodeCache.tooLarge");
+        static Gauge& held = Metrics::gauge("decodeCache.bytes");
+        static Gauge& count = Metrics::gauge("decodeCache.entries");
+
+        // Still handed out, just not kept
+        if (entry.bytes > this->limit) {
+            if (this->limit > 0)
+                too_large.add();
+            return;
+        }
+        if (this->index.contains(entry.key))
+            return;
+
+        this->evict(entry.bytes);
+        this->held_bytes += entry.bytes;
+        this->entries.push_front(entry);
+        this->index[entry.key] = this->entries.begin();
+        held.set(this->held_bytes);
+        count.set(this->entries.size());
+    }
+
+    void DecodedImageCache::evict(size_t needed) {
+        static Counter& evictions = Metrics::counter("decodeCache.evictions");
+        static Counter& evicted_bytes = Metrics::counter("decodeCache.evictedBytes");
+        static Gauge& held = Metrics::gauge("decodeCache.bytes");
+        static Gauge& count = Metrics::gauge("decodeCache.entries");
+
+        while (!this->entries.empty() && this->held_bytes + needed > this->limit) {
+            Entry& oldest = this->entries.back();
+            this->held_bytes -= oldest.bytes;
+            evictions.add();
+            evicted_bytes.add(oldest.bytes);
+            this->index.erase(oldest.key);
+            this->entries.pop_back();
+        }
+        held.set(this->held_bytes);
+        count.set(this->entries.size());
+    }
+
+    void DecodedImageCache::begin_load(std::unique_lock<std::mutex>& lock, std::string key) {
+        this->loaded.wait(lock, [&]() { return !this->loading.contains(key); });
+        this->loading.insert(key);
+    }
+
+    void DecodedImageCache::end_load(std::string key) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->loading.erase(key);
+        }
+        this->loaded.notify_all();
+    }
+
+}
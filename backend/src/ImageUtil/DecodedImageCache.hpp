@@ -0,0 +1,143 @@
+#ifndef BTRGB_DECODED_IMAGE_CACHE_HPP
+#define BTRGB_DECODED_IMAGE_CACHE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "btrgb.hpp"
+#include "ImageUtil/ImageReader/ImageReaderStrategy.hpp"
+
+namespace btrgb {
+
+    /**
+     * @brief A file as one of the readers decoded it
+     * Shared by everyone who asked for the file, the bitmap must never be written to. Clone it first.
+     */
+    class DecodedImage {
+        public:
+            cv::Mat bitmap;
+            exif tags;
+
+            /**
+             * @brief Bit depth of the bitmap's values (BitDepthFinder), found on the first call
+             * @return -1 if the bitmap isn't 16 bit or the bit depth couldn't be found
+             */
+            int bit_depth() const;
+
+        private:
+            mutable std::once_flag bit_depth_once;
+            mutable int found_bit_depth = -1;
+    };
+
+    /**
+     * @brief Everything LibTiffReader parses out of a TIFF besides the pixels
+     */
+    struct TiffMetadata {
+        int width = -1;
+        int height = -1;
+        int channels = -1;
+        int depth = -1;
+        // Empty if the file has no ICC profile
+        std::vector<uint8_t> color_profile;
+        // Matrices of the BTRGB artist tag, empty if it has none
+        std::unordered_map<std::string, cv::Mat> conversion_matrices;
+    };
+
+    /**
+     * @brief Process wide cache of decoded files, shared by every request
+     *
+     * Previews, processing and the viewers all decode the same few files over and over, often seconds
+     * apart. Entries are keyed by the file's path, size and modification time plus how it was decoded,
+     * so a file changed on disk is decoded again. Handouts are reference counted and never copied, an
+     * entry evicted while still in use stays valid for whoever holds it, it just no longer counts
+     * toward the cache's memory.
+     *
+     * When two threads ask for the same file at once, only one decodes it and the other waits for it.
+     * The least recently used entries are evicted once the cache is over its memory limit.
+     *
+     * To use
+     *      std::shared_ptr<const DecodedImage> im = DecodedImageCache::get_instance()->get(file);
+     *      cv::Mat copy = im->bitmap.clone(); // Before changing it
+     */
+    class DecodedImageCache {
+        public:
+            // How raw files are decoded (see LibRawReader), TIFFs are always read whole
+            enum Mode { FULL, DRAFT, PREVIEW };
+
+            static DecodedImageCache* get_instance();
+
+            /**
+             * @brief Set the most bytes of decoded images to hold, 0 disables caching
+             * Evicts entries right away if the cache is over the new limit.
+             */
+            void set_memory_limit(size_t bytes);
+            size_t memory_limit();
+            bool enabled();
+
+            /**
+             * @brief The decoded file, from the cache or decoded now and added to it
+             * Waits if another thread is decoding the same file the same way.
+             * @param reader used to decode on a miss, it must decode the way mode says.
+             *  A reader of the right type is created if nullptr
+             * @throws whatever the reader throws if the file can't be decoded
+             */
+            std::shared_ptr<const DecodedImage> get(std::string filename, Mode mode = FULL, ImageReaderStrategy* reader = nullptr);
+
+            /**
+             * @brief The decoded file if it is cached, nullptr otherwise, never decodes
+             */
+            std::shared_ptr<const DecodedImage> find(std::string filename, Mode mode = FULL);
+
+            /**
+             * @brief The metadata of a TIFF, from the cache or parsed now and added to it
+             * @throws std::runtime_error if the file can't be opened
+             */
+            std::shared_ptr<const TiffMetadata> metadata(std::string filename);
+
+            size_t bytes();
+            int entry_count();
+
+        private:
+            DecodedImageCache() {}
+
+            struct Entry {
+                std::string key;
+                std::shared_ptr<const DecodedImage> image;
+                std::shared_ptr<const TiffMetadata> metadata;
+                size_t bytes = 0;
+            };
+
+            // Empty if the file can't be found
+            static std::string key(std::string filename, std::string kind);
+
+            // Called with mutex held
+            bool lookup(std::string key, Entry& entry);
+            void insert(Entry entry);
+            void evict(size_t needed);
+
+            // Called with mutex held, waits for any other thread loading key and then marks it loading
+            void begin_load(std::unique_lock<std::mutex>& lock, std::string key);
+            void end_load(std::string key);
+
+            std::mutex mutex;
+            std::condition_variable loaded;
+            size_t limit = 0;
+            size_t held_bytes = 0;
+            // Most recently used first
+            std::list<Entry> entries;
+            std::unordered_map<std::string, std::list<Entry>::iterator> index;
+            std::unordered_set<std::string> loading;
+    };
+
+}
+
+#endif
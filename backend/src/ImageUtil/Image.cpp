@@ -1,4 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <lz4.h>
+
 #include "Image.hpp"
+#include "ImageUtil/QoiEncoder.hpp"
+#include "utils/metrics.hpp"
+#include "utils/scratch_allocator.hpp"
+#include "utils/thread_pool.hpp"
 
 
 namespace btrgb {
@@ -15,6 +27,9 @@ namespace btrgb {
 
 
     void Image::initImage(cv::Mat im) {
+        ScratchAllocator* scratch = ScratchAllocator::get_instance();
+        if (this->_scratch || scratch->over_budget(im))
+            im = scratch->to_scratch(im);
         this->_opencv_mat = im;
         this->_bitmap = (float*) im.data;
         this->_width = im.cols;
@@ -22,6 +37,7 @@ namespace btrgb {
         this->_channels = im.channels();
         this->_col_size = this->_channels;
         this->_row_size = this->_width * this->_col_size;
+        this->pixelsChanged();
     }
 
 
@@ -82,7 +98,43 @@ namespace btrgb {
     }
     
 
+    std::shared_ptr<PatchStatistics> Image::getPatchStatistics(cv::Rect region) {
+        _checkInit();
+        region &= cv::Rect(0, 0, this->_width, this->_height);
+        static Counter& hits = Metrics::counter("patchStatistics.hits");
+        static Counter& misses = Metrics::counter("patchStatistics.misses");
+        std::unique_lock<std::mutex> lock(this->_patch_stats_mutex);
+        if (this->_patch_stats == nullptr || !this->_patch_stats->covers(region)) {
+            misses.add();
+            /* Grow the cached region instead of replacing it so alternating requests don't rebuild every time. */
+            if (this->_patch_stats != nullptr)
+                region |= this->_patch_stats->region();
+            this->_patch_stats = std::make_shared<PatchStatistics>(this->_opencv_mat, region);
+        }
+        else {
+            hits.add();
+        }
+        return this->_patch_stats;
+    }
+
+    void Image::setScratchBacked(bool scratch) {
+        this->_scratch = scratch;
+        if (scratch && !this->_opencv_mat.empty())
+            this->initImage(this->_opencv_mat);
+    }
+
+    bool Image::isScratchBacked() {
+        return ScratchAllocator::is_scratch(this->_opencv_mat);
+    }
+
+    void Image::pixelsChanged() {
+        std::unique_lock<std::mutex> lock(this->_patch_stats_mutex);
+        this->_patch_stats.reset();
+    }
+
+
     void Image::recycle() {
+        this->pixelsChanged();
         this->_bitmap = nullptr;
         this->_width = 0;
         this->_height = 0;
@@ -102,70 +154,222 @@ namespace btrgb {
     }
 
 
-    binary_ptr_t Image::getEncodedPNG(enum image_quality quality) {
-        std::vector<int> params;
-        cv::Mat im;
+    namespace {
 
-        /* Convert color space. */
-        cv::Mat im_srgb;
-        if(this->_color_profile == ColorSpace::sRGB)
-            im_srgb = this->_opencv_mat;
-        else {
-            im_srgb = Image::copyMatConvertDepth(this->_opencv_mat, CV_32F);
-            ColorProfiles::convert(im_srgb, this->_color_profile, ColorSpace::sRGB);
+        /* Converts a full image to 8 bit sRGB the same way regardless of its size. */
+        cv::Mat convertToDisplay(cv::Mat im, ColorSpace profile) {
+
+            /* Convert color space. */
+            cv::Mat im_srgb;
+            if(profile == ColorSpace::sRGB)
+                im_srgb = im;
+            else {
+                im_srgb = Image::copyMatConvertDepth(im, CV_32F);
+                ColorProfiles::convert(im_srgb, profile, ColorSpace::sRGB);
+            }
+
+            /* Convert to 8 bit. */
+            if(im_srgb.depth() == CV_8U)
+                return im_srgb;
+            return Image::copyMatConvertDepth(im_srgb, CV_8U);
         }
 
 
-        /* Convert to 8 bit. */
-        cv::Mat im8u;
-        if(im_srgb.depth() == CV_8U)
-            im8u = im_srgb; 
-        else {
-            im8u = Image::copyMatConvertDepth(im_srgb, CV_8U);
-            im_srgb.release();
+        /* sRGB gamma and 8 bit quantization of linear values in [0, 1], looked up instead of using pow() per pixel. */
+        const int GAMMA_LUT_SIZE = 16384;
+
+        const uchar* srgbGammaLUT() {
+            static const std::array<uchar, GAMMA_LUT_SIZE + 1> lut = []() {
+                std::array<uchar, GAMMA_LUT_SIZE + 1> table;
+                for(int i = 0; i <= GAMMA_LUT_SIZE; i++)
+                    table[i] = cv::saturate_cast<uchar>(
+                        ColorProfiles::gamma(float(i) / GAMMA_LUT_SIZE, ColorSpace::sRGB) * 0xFF);
+                return table;
+            }();
+            return lut.data();
         }
 
-        switch(quality) {
-        case FAST:
+        inline uchar lookupGamma(const uchar* lut, float x) {
+            x = x < 0 ? 0 : (x > 1 ? 1 : x);
+            return lut[int(x * GAMMA_LUT_SIZE + 0.5f)];
+        }
+
+
+        /* Linear value of every stored value for integer images, or of GAMMA_LUT_SIZE + 1 evenly
+         * spaced values in [0, 1] for floating point images (interpolated between). */
+        template<typename T>
+        std::vector<float> linearTable(ColorSpace profile) {
+            int levels = std::is_floating_point_v<T> ? GAMMA_LUT_SIZE + 1 : int(std::numeric_limits<T>::max()) + 1;
+            std::vector<float> table(levels);
+            for(int i = 0; i < levels; i++) {
+                float x = float(i) / (levels - 1);
+                /* Without a profile values are already linear, only gamma gets applied. */
+                table[i] = (profile == ColorSpace::none) ? x : ColorProfiles::inverse_gamma(x, profile);
+            }
+            return table;
+        }
 
-            /* Scale the image to have a width of 1920 pixels (keep same aspect ratio). */
-            if(im8u.cols > 1920) {
-                double scaler = double(1920) / double(im8u.cols);
-                cv::resize(im8u, im, cv::Size(), scaler, scaler, cv::INTER_AREA);
+        template<typename T>
+        inline float lookupLinear(const std::vector<float>& table, T value) {
+            if constexpr (std::is_floating_point_v<T>) {
+                float f = float(value < 0 ? 0 : (value > 1 ? 1 : value)) * GAMMA_LUT_SIZE;
+                int i = int(f);
+                if(i >= GAMMA_LUT_SIZE)
+                    return table[GAMMA_LUT_SIZE];
+                return table[i] + (f - i) * (table[i + 1] - table[i]);
             }
             else {
-                im = im8u;
+                return table[value];
             }
-        
+        }
+
+        /* Linearizes a three channel image and averages each k x k block of it into one CV_32FC3 pixel,
+         * so downsampling happens on linear light without a full resolution linear copy. */
+        template<typename T>
+        cv::Mat linearDownsample(const cv::Mat& src, int k, ColorSpace profile) {
+            std::vector<float> table = linearTable<T>(profile);
+            cv::Mat dst((src.rows + k - 1) / k, (src.cols + k - 1) / k, CV_32FC3);
+
+            ThreadPool::get_instance()->parallel_for(0, dst.rows, [&](int begin, int end) {
+                std::vector<float> sums(dst.cols * 3);
+                for(int row = begin; row < end; row++) {
+                    std::fill(sums.begin(), sums.end(), 0.0f);
+                    int y_end = std::min(src.rows, (row + 1) * k);
+                    for(int y = row * k; y < y_end; y++) {
+                        const T* in = src.ptr<T>(y);
+                        for(int x = 0; x < src.cols; x++, in += 3) {
+                            float* sum = &sums[(x / k) * 3];
+                            sum[0] += lookupLinear<T>(table, in[0]);
+                            sum[1] += lookupLinear<T>(table, in[1]);
+                            sum[2] += lookupLinear<T>(table, in[2]);
+                        }
+                    }
+
+                    float* out = dst.ptr<float>(row);
+                    int block_rows = y_end - row * k;
+                    for(int col = 0; col < dst.cols; col++) {
+                        int block_cols = std::min(src.cols, (col + 1) * k) - col * k;
+                        float inv = 1.0f / (block_rows * block_cols);
+                        for(int ch = 0; ch < 3; ch++)
+                            out[col * 3 + ch] = sums[col * 3 + ch] * inv;
+                    }
+                }
+            });
+            return dst;
+        }
+
+        /* Conversion matrix, clipping, sRGB gamma, 8 bit quantization and channel order of a linear CV_32FC3 image. */
+        cv::Mat encodeLinear(const cv::Mat& linear, const cv::Matx33f& m, bool bgr) {
+            cv::Mat dst(linear.rows, linear.cols, CV_8UC3);
+            const uchar* lut = srgbGammaLUT();
+            const int r = bgr ? 2 : 0, b = bgr ? 0 : 2;
+
+            ThreadPool::get_instance()->parallel_for(0, linear.rows, [&](int begin, int end) {
+                for(int row = begin; row < end; row++) {
+                    const float* px = linear.ptr<float>(row);
+                    uchar* out = dst.ptr<uchar>(row);
+                    for(int col = 0; col < linear.cols; col++, px += 3, out += 3) {
+                        out[r] = lookupGamma(lut, m(0,0) * px[0] + m(0,1) * px[1] + m(0,2) * px[2]);
+                        out[1] = lookupGamma(lut, m(1,0) * px[0] + m(1,1) * px[1] + m(1,2) * px[2]);
+                        out[b] = lookupGamma(lut, m(2,0) * px[0] + m(2,1) * px[1] + m(2,2) * px[2]);
+                    }
+                }
+            });
+            return dst;
+        }
+
+    }
+
+
+    cv::Mat Image::_getPreviewMat(bool bgr) {
+        _checkInit();
+        cv::Mat im = this->_opencv_mat;
+        ColorSpace profile = this->_color_profile;
+
+        /* Anything other than RGB goes through the regular conversion, scaled down first. */
+        if(im.channels() != 3) {
+            if(im.cols > DISPLAY_WIDTH) {
+                double scaler = double(DISPLAY_WIDTH) / double(im.cols);
+                cv::Mat small;
+                cv::resize(im, small, cv::Size(), scaler, scaler, cv::INTER_AREA);
+                im = small;
+            }
+            cv::Mat im8u = convertToDisplay(im, profile);
+            if(bgr)
+                cv::cvtColor(im8u, im8u, cv::COLOR_RGB2BGR);
+            return im8u;
+        }
+
+        /* Throws for color spaces that can't be converted yet, before any work is started. */
+        cv::Matx33f m = cv::Matx33f::eye();
+        if(profile != ColorSpace::sRGB && profile != ColorSpace::none) {
+            cv::Mat combined = ColorProfiles::color_matrix(ColorSpace::sRGB) * ColorProfiles::xyz_matrix(profile);
+            m = cv::Matx33f((const float*) combined.data);
+        }
+
+        /* Scale the image down to a width of DISPLAY_WIDTH pixels (keep same aspect ratio) before anything else,
+         * so the color conversion only touches the pixels that are shown, however large the capture is.
+         * Averaging happens on linear values like the full conversion would, gamma encoded ones would darken detail.
+         * Whole blocks are averaged while linearizing, the rest of the way (less than 2x) is an area resize. */
+        int k = std::max(1, im.cols / DISPLAY_WIDTH);
+        cv::Mat linear;
+        switch(im.depth()) {
+            case CV_8U: linear = linearDownsample<uchar>(im, k, profile); break;
+            case CV_16U: linear = linearDownsample<uint16_t>(im, k, profile); break;
+            case CV_32F: linear = linearDownsample<float>(im, k, profile); break;
+            case CV_64F: linear = linearDownsample<double>(im, k, profile); break;
+            default: throw std::runtime_error("[Image::getDisplayMat] Unsupported image depth.");
+        }
+        if(linear.cols > DISPLAY_WIDTH) {
+            double scaler = double(DISPLAY_WIDTH) / double(linear.cols);
+            cv::resize(linear, linear, cv::Size(), scaler, scaler, cv::INTER_AREA);
+        }
+
+        /* Color conversion, gamma, 8 bit quantization and channel order in a single pass. */
+        return encodeLinear(linear, m, bgr);
+    }
+
+
+    cv::Mat Image::getDisplayMat(enum image_quality quality) {
+        switch(quality) {
+        case FAST:
+            return this->_getPreviewMat(false);
+
+        case FULL:
+            return convertToDisplay(this->_opencv_mat, this->_color_profile);
+
+        default:
+            throw std::logic_error("[Image::getDisplayMat] Invalid quality type. ");
+        }
+    }
+
+    cv::Mat Image::_getDisplayMat(enum image_quality quality, bool bgr) {
+        if(quality == FAST)
+            return this->_getPreviewMat(bgr);
+
+        cv::Mat im = this->getDisplayMat(quality);
+        if(bgr && im.channels() == 3) {
+            cv::Mat im_bgr;
+            cv::cvtColor(im, im_bgr, cv::COLOR_RGB2BGR);
+            return im_bgr;
+        }
+        return im;
+    }
+
+    binary_ptr_t Image::getEncodedPNG(enum image_quality quality) {
+        std::vector<int> params;
+
+        if(quality == FAST) {
             /* Set compression parameters for use later. */
             params = {
                 cv::IMWRITE_PNG_COMPRESSION, 1,
                 cv::IMWRITE_PNG_STRATEGY, cv::IMWRITE_PNG_STRATEGY_HUFFMAN_ONLY,
             };
-            break;
-
-        case FULL:
-        
-            /* Convert to 16 bit. */
-            /*if(im_srgb.depth() == CV_16U)
-                im = im_srgb;
-            else {
-                im = Image::copyMatConvertDepth(im_srgb, CV_16U);
-                im_srgb.release();
-            }*/
-            im = im8u;
-
-            /* Use default PNG compression parameters. */
-            params = {};
-            break;
-
-        default:
-            throw std::logic_error("[Image::getBinaryOfType] Invalid quality type. ");
         }
+        /* Otherwise use default PNG compression parameters. */
 
-        /* Convert to BGR order for OpenCV. */
-        cv::Mat im_bgr;
-        cv::cvtColor(im, im_bgr, cv::COLOR_RGB2BGR);
+        /* BGR order for OpenCV. */
+        cv::Mat im_bgr = this->_getDisplayMat(quality, true);
 
         /* Encode image. */
         binary_ptr_t result_binary(new std::vector<uchar>);
@@ -178,6 +382,55 @@ namespace btrgb {
         return result_binary;
     }
 
+    binary_ptr_t Image::getEncoded(enum image_quality quality, enum output_type type) {
+        binary_ptr_t result_binary(new std::vector<uchar>);
+
+        switch(type) {
+        case PNG:
+            return this->getEncodedPNG(quality);
+
+        case JPEG: {
+            std::vector<int> params = { cv::IMWRITE_JPEG_QUALITY, 95 };
+            try { cv::imencode(".jpg", this->_getDisplayMat(quality, true), *result_binary, params); }
+            catch(const cv::Exception& ex) {
+                throw FailedToEncode();
+            }
+            break;
+        }
+
+        case QOI:
+            QoiEncoder::encode(this->_getDisplayMat(quality, false), *result_binary);
+            break;
+
+        case RGB: {
+            cv::Mat im = this->_getDisplayMat(quality, false);
+            if(!im.isContinuous())
+                im = im.clone();
+            int raw_bytes = im.total() * im.elemSize();
+            uint32_t header[3] = { uint32_t(im.cols), uint32_t(im.rows), uint32_t(im.channels()) };
+            result_binary->resize(sizeof(header) + LZ4_compressBound(raw_bytes));
+
+            uchar* out = result_binary->data();
+            for(uint32_t value : header)
+                for(int i = 0; i < 4; i++)
+                    *out++ = (value >> (8 * i)) & 0xFF;
+
+            /* The pixel size is known from the header, so a single LZ4 block is enough. */
+            int compressed_bytes = LZ4_compress_default((const char*) im.data, (char*) out,
+                raw_bytes, LZ4_compressBound(raw_bytes));
+            if(compressed_bytes <= 0)
+                throw FailedToEncode();
+            result_binary->resize(sizeof(header) + compressed_bytes);
+            break;
+        }
+
+        default:
+            throw std::logic_error("[Image::getEncoded] Invalid image type. ");
+        }
+
+        return result_binary;
+    }
+
 
 
     void Image::setColorProfile(ColorSpace color_profile) {
@@ -5,11 +5,13 @@
 #include <string>
 #include <opencv2/opencv.hpp>
 #include <filesystem>
+#include <mutex>
 #include <unordered_map>
 namespace fs = std::filesystem;
 
 #include "btrgb.hpp"
 #include "ImageUtil/ColorProfiles.hpp"
+#include "ImageUtil/PatchStatistics.hpp"
 
 /* Ways to loop:
 
@@ -68,13 +70,18 @@ namespace btrgb {
     enum output_type {
         PNG,
         TIFF,
-        JPEG
+        JPEG,
+        QOI,
+        RGB
     };
 
     enum image_quality {
         FAST, FULL
     };
 
+    // Widest a FAST quality display image gets
+    #define DISPLAY_WIDTH 1920
+
     class Image {
         public:
             Image(std::string filename);
@@ -97,8 +104,23 @@ namespace btrgb {
             std::string getName();
             void setName(std::string name);
 
+            /**
+             * @brief The image as it should be displayed: sRGB, 8 bit, RGB order.
+             * FAST quality is scaled down to a width of at most 1920 pixels.
+             * May share data with the image if no conversion was needed.
+             */
+            cv::Mat getDisplayMat(enum image_quality quality);
             binary_ptr_t getEncodedPNG(enum image_quality quality);
 
+            /**
+             * @brief Encode the display image for sending to the frontend
+             * RGB is the 8 bit pixels row by row compressed as one LZ4 block, after a 12 byte
+             * header holding the width, height and channel count (uint32 little endian).
+             *
+             * @param type PNG, JPEG, QOI or RGB
+             */
+            binary_ptr_t getEncoded(enum image_quality quality, enum output_type type);
+
             void setColorProfile(ColorSpace color_profile);
             ColorSpace getColorProfile();
 
@@ -122,6 +144,30 @@ namespace btrgb {
             }
 
 
+            /**
+             * @brief Get summed area tables covering the given region of the image
+             * The tables are cached on the image and reused until pixelsChanged() is called
+             * (or the image is re-initialized/recycled).
+             *
+             * @param region the region the tables should cover
+             * @return std::shared_ptr<PatchStatistics>
+             */
+            std::shared_ptr<PatchStatistics> getPatchStatistics(cv::Rect region);
+
+            /**
+             * @brief Must be called after modifying pixel values in place
+             * Drops any cached data that was derived from the pixel values.
+             */
+            void pixelsChanged();
+
+            /**
+             * @brief Keep the pixel data in a memory-mapped scratch file instead of RAM
+             * Applies to the current data and anything passed to initImage() afterwards.
+             * Images are also moved to scratch without this when the memory budget is exceeded.
+             */
+            void setScratchBacked(bool scratch);
+            bool isScratchBacked();
+
             void recycle();
             std::shared_ptr<int> _raw_bit_depth;
             
@@ -142,8 +188,14 @@ namespace btrgb {
             cv::Mat _opencv_mat;
             ColorSpace _color_profile = none;
             std::unordered_map<std::string, cv::Mat> _conversions;
+            std::shared_ptr<PatchStatistics> _patch_stats;
+            // Calibrators running side by side share the art images
+            std::mutex _patch_stats_mutex;
+            bool _scratch = false;
 
             void _checkInit();
+            cv::Mat _getPreviewMat(bool bgr);
+            cv::Mat _getDisplayMat(enum image_quality quality, bool bgr);
     };
 
     class ImageError : public std::exception {};
@@ -28,6 +28,13 @@ void LibRawReader::recycle() {
 void LibRawReader::_configLibRawParams() {
 	libraw_output_params_t* opt = &( this->_reader.imgdata.params );
     switch(this->_method) {
+
+    case DRAFT:
+
+        /* Same as UNPROCESSED but use each 2x2 bayer as one pixel. */
+        opt->half_size = 1;
+
+        [[fallthrough]];
         
     case UNPROCESSED:
 
@@ -165,7 +172,8 @@ static void exif_callback(void *context, int tag, int type, int len, unsigned in
 
     LibRaw_abstract_datastream* data = static_cast<LibRaw_abstract_datastream*>(ifp);
     btrgb::exif *tags = static_cast<btrgb::exif*>(context);
-    static char buffer[BTRGB_BUFFER_LENGTH] = {0};
+    // LibRaw can be reading files on several threads at once
+    static thread_local char buffer[BTRGB_BUFFER_LENGTH] = {0};
     
     tag &= 0x0fffff; // Undo (ifdN + 1) << 20)
     switch (tag) {
@@ -12,7 +12,8 @@ namespace btrgb {
 class LibRawReader : public ImageReaderStrategy {
 
     public:
-        enum libraw_type { PREVIEW, UNPROCESSED };
+        /* DRAFT is UNPROCESSED at half resolution (each 2x2 bayer becomes one pixel). */
+        enum libraw_type { PREVIEW, UNPROCESSED, DRAFT };
         LibRawReader(libraw_type method = UNPROCESSED);
         ~LibRawReader();
 
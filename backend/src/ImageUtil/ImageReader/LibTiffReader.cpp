@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "LibTiffReader.hpp"
 
 namespace btrgb {
@@ -172,6 +174,64 @@ cv::Mat LibTiffReader::getCrop(uint32_t left, uint32_t top, uint32_t w, uint32_t
 }
 
 
+cv::Mat LibTiffReader::getSubsampled(uint32_t step) {
+    if( ! this->_is_open )
+        throw std::runtime_error("[LibTiffReader] No file opened.");
+
+    if(TIFFIsTiled(this->_tiff))
+        throw std::runtime_error("[LibTiffReader] Tiled tiffs can not be subsampled.");
+
+    if(step < 1)
+        step = 1;
+
+    int sample_byte_size = this->_depth / 8;
+    size_t pixel_size = this->_channels * sample_byte_size;
+    size_t row_size = size_t(this->_width) * pixel_size;
+    int rows = (this->_height + step - 1) / step;
+    int cols = (this->_width + step - 1) / step;
+
+    int cv_depth = this->getCVMatType();
+    cv::Mat sampled(rows, cols, CV_MAKETYPE(cv_depth, _channels));
+
+    uint32_t rows_per_strip = this->_height;
+    TIFFGetFieldDefaulted(this->_tiff, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+    if(rows_per_strip < 1)
+        rows_per_strip = 1;
+
+    tmsize_t strip_data_size = TIFFStripSize(this->_tiff);
+    if(strip_data_size < 0 || size_t(strip_data_size) < row_size * std::min<uint32_t>(rows_per_strip, this->_height))
+        throw std::runtime_error("[LibTiffReader] Strip size assumption failed.");
+
+	void* strip_data = _TIFFmalloc(strip_data_size);
+    if( ! strip_data )
+        throw std::runtime_error("[LibTiffReader] Memory error.");
+
+    /* Consecutive sampled rows often share a strip, each strip is only decoded once. */
+    int64_t loaded_strip = -1;
+    for(int row = 0; row < rows; row++) {
+        uint32_t src_row = row * step;
+        uint32_t strip_index = src_row / rows_per_strip;
+
+        if(strip_index != loaded_strip) {
+            if(TIFFReadEncodedStrip(this->_tiff, strip_index, strip_data, strip_data_size) < 0) {
+                _TIFFfree(strip_data);
+                throw std::runtime_error("[LibTiffReader] Failed to read strip #" + std::to_string(strip_index));
+            }
+            loaded_strip = strip_index;
+        }
+
+        uchar* src = (uchar*)strip_data + (src_row % rows_per_strip) * row_size;
+        uchar* dst = sampled.ptr<uchar>(row);
+        for(int col = 0; col < cols; col++)
+            memcpy(dst + col * pixel_size, src + size_t(col) * step * pixel_size, pixel_size);
+    }
+
+	_TIFFfree(strip_data);
+
+    return sampled;
+}
+
+
 std::string LibTiffReader::getColorSpaceString() {
     if( ! this->_is_open )
         throw std::runtime_error("[LibTiffReader] No file opened.");
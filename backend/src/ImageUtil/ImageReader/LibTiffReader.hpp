@@ -23,6 +23,8 @@ class LibTiffReader : public ImageReaderStrategy {
         void copyBitmapTo(cv::Mat& im) override;
 
         cv::Mat getCrop(uint32_t left, uint32_t top, uint32_t width, uint32_t height);
+        /* Every step-th pixel of every step-th row, only the strips holding those rows are read. */
+        cv::Mat getSubsampled(uint32_t step);
         std::unordered_map<std::string, cv::Mat> getConversionMatrices();
         cv::Mat getConversionMatrix(std::string key);
         std::string getColorSpaceString();
@@ -13,24 +13,76 @@ namespace btrgb {
     std::vector<uint8_t>* buffer, 
     int special_input_bit_depth) {
 
-        int height = im->height();
-        int width = im->width();
-        int channels = im->channels();
-
         cv::Mat im_8u;
-		im->getMat().convertTo(im_8u, CV_8U, 0xFF);
-        uint8_t* bitmap = (uint8_t*) im_8u.data;
-
+        if(im->getMat().depth() == CV_8U)
+            im_8u = im->getMat();
+        else
+            im->getMat().convertTo(im_8u, CV_8U, 0xFF);
 
-        bool write_to_file = (buffer == nullptr);
-        FILE* output_file;
-
-        if( write_to_file ) {
+        if( buffer == nullptr ) {
             /* ============[ Open file for writing ]============== */
-            output_file = fopen(filename.c_str(), "wb");
+            FILE* output_file = fopen(filename.c_str(), "wb");
             if(output_file == NULL)
                 throw Libpng_OpenFileFailed();
+
+            try { this->_encode(im_8u, output_file, nullptr, nullptr); }
+            catch(...) {
+                fclose(output_file);
+                throw;
+            }
+		    fclose(output_file);
+        }
+        else {
+            /* ============[ Set output buffer for png ]============== */
+
+            /* Overshoot of estimated size (because of compression) */
+            buffer->reserve(im_8u.total() * im_8u.channels());
+
+            this->_encode(im_8u, nullptr, buffer,
+                [](png_structp  png_ptr, png_bytep data, png_size_t length) {
+                    std::vector<uint8_t>* buffer = (std::vector<uint8_t>*) png_get_io_ptr(png_ptr);
+                    buffer->insert(buffer->end(), data, data + length);
+                });
         }
+    }
+
+    void LibpngWriter::stream_png(cv::Mat im_8u, const png_sink_t& sink) {
+        if(im_8u.depth() != CV_8U)
+            throw std::logic_error("[LibpngWriter::stream_png] Image must be 8 bit. ");
+
+        /* libpng's own compression buffer is handed to the sink as it fills up.
+         * The sink may block or throw (e.g. when cancelled), but exceptions can't unwind through
+         * libpng's C frames. They are stashed, libpng bails out through png_error, and
+         * _encode rethrows them once libpng is cleaned up. */
+        struct SinkContext {
+            const png_sink_t* sink;
+            std::exception_ptr error;
+        } context = { &sink, nullptr };
+
+        this->_encode(im_8u, nullptr, (png_voidp) &context,
+            [](png_structp  png_ptr, png_bytep data, png_size_t length) {
+                SinkContext* context = (SinkContext*) png_get_io_ptr(png_ptr);
+                /* Jump out only once the handler is done, longjmp out of a catch block never ends it. */
+                bool failed = false;
+                try {
+                    (*context->sink)(data, length);
+                }
+                catch(...) {
+                    context->error = std::current_exception();
+                    failed = true;
+                }
+                if(failed)
+                    png_error(png_ptr, "Output sink failed.");
+            }, &context.error);
+    }
+
+    void LibpngWriter::_encode(cv::Mat im_8u, FILE* output_file, png_voidp io_ptr, png_rw_ptr write_fn,
+            std::exception_ptr* write_error) {
+
+        int height = im_8u.rows;
+        int width = im_8u.cols;
+        int channels = im_8u.channels();
+        int src_channels = channels;
 
         /* ============[ Create png_struct ]============== */
         png_structp png_ptr = png_create_write_struct(
@@ -40,8 +92,6 @@ namespace btrgb {
             NULL /*user_warning_fn*/
             );
         if (!png_ptr) {
-            if( write_to_file )
-                fclose(output_file);
             throw Libpng_LibraryInitFailed();
         }
 
@@ -49,51 +99,46 @@ namespace btrgb {
         png_infop info_ptr = png_create_info_struct(png_ptr);
         if (!info_ptr) {
             png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
-            if( write_to_file )
-                fclose(output_file);
             throw Libpng_LibraryInitFailed();
         }
 
+        int color_type;
+        if(channels < 3) {
+            /* If there are two channels, just show the first one. */
+            color_type = PNG_COLOR_TYPE_GRAY;
+            channels = 1;
+        }
+        else {
+            /* If there are mroe than three, just show the first three as RGB. */
+            color_type = PNG_COLOR_TYPE_RGB;
+            channels = 3;
+        }
+
+        /* Allocated before setjmp and never reassigned after it, so it is intact
+         * (and freed) when libpng jumps back. */
+        uint32_t size_of_row = width * channels * 1; /* 8 bit (1 byte) */
+        std::vector<png_byte> output_row(size_of_row);
+
         /* ============[ Set up error jumping? ]============== */
         if (setjmp(png_jmpbuf(png_ptr))) {
             png_destroy_write_struct(&png_ptr, &info_ptr);
-            if( write_to_file )
-                fclose(output_file);
+            if (write_error != nullptr && *write_error)
+                std::rethrow_exception(*write_error);
             throw Libpng_LibraryInitFailed();
         }
 
-        if ( write_to_file ) {
+        if ( write_fn == nullptr ) {
             /* ============[ Set output file for png ]============== */
             png_init_io(png_ptr, output_file);
         }
         else { 
-            /* ============[ Set output buffer for png ]============== */
-
-            /* Overshoot of estimated size (because of compression) */
-            buffer->reserve(width * height * channels);
-
-            png_set_write_fn(png_ptr, buffer, 
-                [](png_structp  png_ptr, png_bytep data, png_size_t length) {
-                    std::vector<uint8_t>* buffer = (std::vector<uint8_t>*) png_get_io_ptr(png_ptr);
-                    buffer->insert(buffer->end(), data, data + length);
-                }, 
+            /* ============[ Set output callback for png ]============== */
+            png_set_write_fn(png_ptr, io_ptr, write_fn, 
                 [](png_structp png_ptr) {
                     /* Flush callback. */
                 });
         }
 
-        int color_type;
-        if(channels < 3) {
-            /* If there are two channels, just show the first one. */
-            color_type = PNG_COLOR_TYPE_GRAY;
-            channels = 1;
-        }
-        else {
-            /* If there are mroe than three, just show the first three as RGB. */
-            color_type = PNG_COLOR_TYPE_RGB;
-            channels = 3;
-        }
-
         /* ============[ Set main png info ]============== */
         png_set_IHDR(png_ptr, info_ptr, 
             width, 
@@ -131,9 +176,7 @@ namespace btrgb {
         png_write_info(png_ptr, info_ptr);
 
         /* ============[ Write each row ]============== */
-        uint32_t size_of_row = width * channels * 1; /* 8 bit (1 byte) */
         uint32_t row_index;
-        png_bytep output_row = new png_byte[size_of_row];
 
 
         uint32_t ch, x, y, i;
@@ -141,21 +184,21 @@ namespace btrgb {
             
             /* Start next row. */
             row_index = 0;
+            const uint8_t* bitmap = im_8u.ptr<uint8_t>(y);
 
             /* Copy/convert bitmap row to png output row. */
             for( x = 0; x < width; x++) {
                 for( ch = 0; ch < channels; ch++) {
-                    i = im->getIndex(y, x, ch);
+                    i = x * src_channels + ch;
                     /* Fast, lossy conversion to 8 bit. */
                     output_row[row_index++] = png_byte(bitmap[i]);
                 }
             }
 
             /* Write row. */
-            png_write_row(png_ptr, output_row);
+            png_write_row(png_ptr, output_row.data());
             
         }
-        delete[] output_row;
 
 
         /* ============[ End png writing ]============== */
@@ -164,8 +207,5 @@ namespace btrgb {
 
         /* ============[ Cleanup ]============== */
         png_destroy_write_struct(&png_ptr, &info_ptr);
-
-        if(write_to_file)
-		    fclose(output_file);
 	}
 }
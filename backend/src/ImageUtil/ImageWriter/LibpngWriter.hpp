@@ -5,6 +5,8 @@
 #include <string>
 #include <stdio.h>
 #include <stdint.h>
+#include <exception>
+#include <functional>
 
 #include <zlib.h>
 #include <png.h>
@@ -15,6 +17,9 @@
 
 
 namespace btrgb {
+
+    /* Receives encoded png bytes in order, the data is only valid during the call. */
+    typedef std::function<void(const uint8_t* data, size_t length)> png_sink_t;
     
     class LibpngWriter : public ImageWriterStrategy {
 
@@ -25,9 +30,24 @@ namespace btrgb {
                 std::vector<uint8_t>* buffer = nullptr,
                 int special_input_bit_depth = -1);
 
+            /**
+             * @brief Encode an 8 bit image, passing the output to sink as it is produced.
+             * The png is flushed every ten rows, so the sink starts receiving data
+             * long before the whole image is encoded.
+             *
+             * @param im_8u 8 bit image with 1 or 3+ channels, only the first three are written
+             * @param sink called with each piece of encoded output
+             */
+            void stream_png(cv::Mat im_8u, const png_sink_t& sink);
+
         protected:
             void _write(Image* im, std::string filename) override;
 
+        private:
+            /* write_error: set by write_fn before it calls png_error, rethrown after libpng is cleaned up */
+            void _encode(cv::Mat im_8u, FILE* output_file, png_voidp io_ptr, png_rw_ptr write_fn,
+                std::exception_ptr* write_error = nullptr);
+
     };
 
 
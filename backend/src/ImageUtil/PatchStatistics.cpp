@@ -0,0 +1,64 @@
+#include "PatchStatistics.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace btrgb {
+
+    PatchStatistics::PatchStatistics(cv::Mat im, cv::Rect region) {
+        this->_region = region & cv::Rect(0, 0, im.cols, im.rows);
+        if(this->_region.empty())
+            throw PatchStatisticsError("Region does not overlap the image.");
+
+        std::vector<cv::Mat> channels;
+        cv::split(im(this->_region), channels);
+        this->_sums.resize(channels.size());
+        this->_sq_sums.resize(channels.size());
+
+        /* Tables are kept in double so large targets do not lose precision. */
+        btrgb::ThreadPool::get_instance()->parallel_for(0, channels.size(), [&](int start, int end) {
+            for(int ch = start; ch < end; ch++)
+                cv::integral(channels[ch], this->_sums[ch], this->_sq_sums[ch], CV_64F, CV_64F);
+        });
+    }
+
+    bool PatchStatistics::covers(cv::Rect rect) {
+        return (rect & this->_region) == rect;
+    }
+
+    cv::Rect PatchStatistics::region() {
+        return this->_region;
+    }
+
+    double PatchStatistics::sum(cv::Rect rect, int chan) {
+        return this->_box(this->_sums.at(chan), rect);
+    }
+
+    double PatchStatistics::sq_sum(cv::Rect rect, int chan) {
+        return this->_box(this->_sq_sums.at(chan), rect);
+    }
+
+    double PatchStatistics::mean(cv::Rect rect, int chan) {
+        return this->sum(rect, chan) / rect.area();
+    }
+
+    double PatchStatistics::variance(cv::Rect rect, int chan) {
+        double n = rect.area();
+        double mean = this->sum(rect, chan) / n;
+        double var = this->sq_sum(rect, chan) / n - mean * mean;
+        // Rounding can make a flat patch come out slightly negative
+        return var < 0 ? 0 : var;
+    }
+
+    double PatchStatistics::_box(cv::Mat& table, cv::Rect rect) {
+        if(!this->covers(rect))
+            throw PatchStatisticsError("Rectangle is outside of the integrated region.");
+
+        /* Move into table coordinates, the table has an extra leading row and col of zeros. */
+        int x0 = rect.x - this->_region.x;
+        int y0 = rect.y - this->_region.y;
+        int x1 = x0 + rect.width;
+        int y1 = y0 + rect.height;
+        return table.at<double>(y1, x1) - table.at<double>(y0, x1)
+             - table.at<double>(y1, x0) + table.at<double>(y0, x0);
+    }
+
+}
@@ -0,0 +1,90 @@
+#ifndef BTRGB_PATCH_STATISTICS_HPP
+#define BTRGB_PATCH_STATISTICS_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief Summed area tables (integral images) over a region of an image
+     * Once built, the sum, mean and variance of any rectangle inside of the region
+     * can be found in constant time for any channel.
+     *
+     * A table is built for the pixel values and one for the squared pixel values of each channel.
+     * Only the region given (usually the bounding box of a ColorTarget) is integrated
+     * so the cost of building is proportional to the size of the target, not the whole image.
+     */
+    class PatchStatistics {
+        public:
+            /**
+             * @brief Build the tables for the given region of the image
+             *
+             * @param im the image to integrate, any number of channels
+             * @param region the region of the image to integrate, this gets clipped to the image bounds
+             */
+            PatchStatistics(cv::Mat im, cv::Rect region);
+
+            /**
+             * @brief Check if the given rectangle is fully contained by the integrated region
+             *
+             * @param rect rectangle in image coordinates
+             * @return true if the rectangle can be queried
+             */
+            bool covers(cv::Rect rect);
+
+            /**
+             * @brief The integrated region in image coordinates
+             */
+            cv::Rect region();
+
+            /**
+             * @brief Sum of all pixel values of a channel within rect
+             *
+             * @param rect rectangle in image coordinates, must be covered by the region
+             * @param chan the channel
+             * @return double
+             */
+            double sum(cv::Rect rect, int chan);
+
+            /**
+             * @brief Sum of all squared pixel values of a channel within rect
+             *
+             * @param rect rectangle in image coordinates, must be covered by the region
+             * @param chan the channel
+             * @return double
+             */
+            double sq_sum(cv::Rect rect, int chan);
+
+            /**
+             * @brief Mean pixel value of a channel within rect
+             */
+            double mean(cv::Rect rect, int chan);
+
+            /**
+             * @brief Population variance of the pixel values of a channel within rect
+             */
+            double variance(cv::Rect rect, int chan);
+
+        private:
+            cv::Rect _region;
+            // One (h+1)x(w+1) CV_64F table per channel
+            std::vector<cv::Mat> _sums;
+            std::vector<cv::Mat> _sq_sums;
+
+            double _box(cv::Mat& table, cv::Rect rect);
+    };
+
+    class PatchStatisticsError : public std::exception {
+        private:
+            std::string msg;
+        public:
+            PatchStatisticsError(std::string msg) {
+                this->msg = "[PatchStatistics] " + msg;
+            }
+            virtual char const * what() const noexcept { return  this->msg.c_str(); }
+    };
+
+}
+
+#endif
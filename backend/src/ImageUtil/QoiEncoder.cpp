@@ -0,0 +1,112 @@
+#include <cstring>
+#include "QoiEncoder.hpp"
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MAX_RUN  62
+#define QOI_HASH(p) ((p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64)
+
+namespace btrgb {
+
+    namespace {
+        struct Rgba {
+            uchar r, g, b, a;
+            bool operator==(const Rgba& other) const {
+                return r == other.r && g == other.g && b == other.b && a == other.a;
+            }
+        };
+
+        void push_u32_be(std::vector<uchar>& out, uint32_t v) {
+            out.push_back(v >> 24);
+            out.push_back(v >> 16);
+            out.push_back(v >> 8);
+            out.push_back(v);
+        }
+    }
+
+    void QoiEncoder::encode(cv::Mat im_8u, std::vector<uchar>& output) {
+        if(im_8u.depth() != CV_8U)
+            throw std::logic_error("[QoiEncoder::encode] Only 8 bit images are supported.");
+        if(im_8u.channels() == 1)
+            cv::cvtColor(im_8u, im_8u, cv::COLOR_GRAY2RGB);
+        int channels = im_8u.channels();
+        if(channels != 3 && channels != 4)
+            throw std::logic_error("[QoiEncoder::encode] Only 1, 3 or 4 channel images are supported.");
+
+        /* Header, then at most one byte more than the pixel itself per pixel. */
+        output.clear();
+        output.reserve(14 + size_t(im_8u.total()) * (channels + 1) + 8);
+        output.insert(output.end(), {'q', 'o', 'i', 'f'});
+        push_u32_be(output, im_8u.cols);
+        push_u32_be(output, im_8u.rows);
+        output.push_back(channels);
+        output.push_back(0); // sRGB with linear alpha
+
+        Rgba index[64];
+        std::memset(index, 0, sizeof(index));
+        Rgba prev = {0, 0, 0, 255};
+        int run = 0;
+
+        for(int row = 0; row < im_8u.rows; row++) {
+            const uchar* in = im_8u.ptr<uchar>(row);
+            for(int col = 0; col < im_8u.cols; col++, in += channels) {
+                Rgba px = {in[0], in[1], in[2], channels == 4 ? in[3] : uchar(255)};
+
+                if(px == prev) {
+                    if(++run == QOI_MAX_RUN) {
+                        output.push_back(QOI_OP_RUN | (run - 1));
+                        run = 0;
+                    }
+                    continue;
+                }
+
+                if(run > 0) {
+                    output.push_back(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+
+                int hash = QOI_HASH(px);
+                if(index[hash] == px) {
+                    output.push_back(QOI_OP_INDEX | hash);
+                }
+                else {
+                    index[hash] = px;
+
+                    if(px.a == prev.a) {
+                        signed char vr = px.r - prev.r;
+                        signed char vg = px.g - prev.g;
+                        signed char vb = px.b - prev.b;
+                        signed char vg_r = vr - vg;
+                        signed char vg_b = vb - vg;
+
+                        if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                            output.push_back(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                        }
+                        else if(vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                            output.push_back(QOI_OP_LUMA | (vg + 32));
+                            output.push_back((vg_r + 8) << 4 | (vg_b + 8));
+                        }
+                        else {
+                            output.insert(output.end(), {QOI_OP_RGB, px.r, px.g, px.b});
+                        }
+                    }
+                    else {
+                        output.insert(output.end(), {QOI_OP_RGBA, px.r, px.g, px.b, px.a});
+                    }
+                }
+                prev = px;
+            }
+        }
+
+        if(run > 0)
+            output.push_back(QOI_OP_RUN | (run - 1));
+
+        /* End marker. */
+        output.insert(output.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    }
+
+}
@@ -0,0 +1,27 @@
+#ifndef BTRGB_QOI_ENCODER_HPP
+#define BTRGB_QOI_ENCODER_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief Encoder for the "Quite OK Image" format (https://qoiformat.org)
+     * Lossless like png but encodes in a single pass with no entropy coding, several times faster.
+     * Meant for sending images to a frontend on the same machine, where size matters less than time.
+     */
+    class QoiEncoder {
+        public:
+            /**
+             * @brief Encode an 8 bit image
+             *
+             * @param im_8u 8 bit image with 3 (RGB) or 4 (RGBA) channels, 1 channel images are written as RGB
+             * @param output replaced with the encoded image
+             */
+            static void encode(cv::Mat im_8u, std::vector<uchar>& output);
+    };
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "ThumbnailCache.hpp"
+#include "ImageUtil/CheckpointCache.hpp"
+#include "utils/metrics.hpp"
+
+namespace fs = std::filesystem;
+
+namespace btrgb {
+
+    ThumbnailCache::ThumbnailCache() {
+        this->directory = (fs::temp_directory_path() / "btrgb_thumbnails").string();
+    }
+
+    ThumbnailCache* ThumbnailCache::get_instance() {
+        static ThumbnailCache instance;
+        return &instance;
+    }
+
+    void ThumbnailCache::set_directory(std::string dir) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->directory = dir;
+    }
+
+    std::string ThumbnailCache::get_directory() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->directory;
+    }
+
+    void ThumbnailCache::set_size_limit(size_t bytes) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->size_limit = bytes;
+    }
+
+    bool ThumbnailCache::enabled() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->size_limit > 0;
+    }
+
+    std::string ThumbnailCache::path(std::string filename) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(filename, ec);
+        if (ec)
+            return "";
+        int64_t modified = fs::last_write_time(filename, ec).time_since_epoch().count();
+        if (ec)
+            return "";
+
+        uint32_t version = FORMAT_VERSION;
+        uint64_t key = CheckpointCache::hash(&version, sizeof(version));
+        key = CheckpointCache::hash(fs::absolute(filename, ec).string(), key);
+        key = CheckpointCache::hash(&size, sizeof(size), key);
+        key = CheckpointCache::hash(&modified, sizeof(modified), key);
+
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key;
+        return (fs::path(this->get_directory()) / name.str()).string();
+    }
+
+    bool ThumbnailCache::load(std::string filename, std::vector<uchar>& encoded, enum output_type& type) {
+        static Counter& hits = Metrics::counter("thumbnails.hits");
+        static Counter& misses = Metrics::counter("thumbnails.misses");
+        if (!this->enabled())
+            return false;
+
+        std::string base = this->path(filename);
+        if (base.empty()) {
+            misses.add();
+            return false;
+        }
+
+        for (enum output_type candidate : {PNG, JPEG}) {
+            std::string file_path = base + (candidate == PNG ? ".png" : ".jpg");
+            std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                continue;
+
+            std::streamsize length = file.tellg();
+            file.seekg(0);
+            encoded.resize(length);
+            if (length <= 0 || !file.read((char*) encoded.data(), length)) {
+                encoded.clear();
+                continue;
+            }
+
+            // Recently used thumbnails are the last to be trimmed
+            std::error_code ec;
+            fs::last_write_time(file_path, fs::file_time_type::clock::now(), ec);
+            type = candidate;
+            hits.add();
+            return true;
+        }
+        misses.add();
+        return false;
+    }
+
+    void ThumbnailCache::store(std::string filename, const std::vector<uchar>& encoded, enum output_type type) {
+        if (!this->enabled() || encoded.empty())
+            return;
+        std::string base = this->path(filename);
+        if (base.empty())
+            return;
+
+        std::error_code ec;
+        fs::create_directories(this->get_directory(), ec);
+
+        // Written under a name unique to this thread, other requests may be storing the same thumbnail
+        std::string file_path = base + (type == JPEG ? ".jpg" : ".png");
+        std::stringstream tmp_path;
+        tmp_path << file_path << "." << std::this_thread::get_id() << ".tmp";
+        {
+            std::ofstream file(tmp_path.str(), std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return;
+            file.write((const char*) encoded.data(), encoded.size());
+            if (!file) {
+                file.close();
+                fs::remove(tmp_path.str(), ec);
+                return;
+            }
+        }
+        fs::rename(tmp_path.str(), file_path, ec);
+        if (ec)
+            fs::remove(tmp_path.str(), ec);
+    }
+
+    void ThumbnailCache::trim() {
+        size_t limit;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            limit = this->size_limit;
+        }
+
+        std::error_code ec;
+        std::vector<fs::directory_entry> thumbnails;
+        uintmax_t total = 0;
+        for (const fs::directory_entry& entry : fs::directory_iterator(this->get_directory(), ec)) {
+            std::string extension = entry.path().extension().string();
+            if ((extension != ".png" && extension != ".jpg") || !entry.is_regular_file(ec))
+                continue;
+            thumbnails.push_back(entry);
+            total += entry.file_size(ec);
+        }
+
+        std::sort(thumbnails.begin(), thumbnails.end(), [&](const fs::directory_entry& a, const fs::directory_entry& b) {
+            return a.last_write_time(ec) < b.last_write_time(ec);
+        });
+        for (const fs::directory_entry& entry : thumbnails) {
+            if (total <= limit)
+                break;
+            uintmax_t size = entry.file_size(ec);
+            if (fs::remove(entry.path(), ec))
+                total -= size;
+        }
+    }
+
+}
@@ -0,0 +1,71 @@
+#ifndef BTRGB_THUMBNAIL_CACHE_HPP
+#define BTRGB_THUMBNAIL_CACHE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ImageUtil/Image.hpp"
+
+namespace btrgb {
+
+    /**
+     * @brief On-disk cache of the encoded thumbnails sent for each file, so browsing a folder again
+     * doesn't extract them again, even after a restart
+     *
+     * Thumbnails are keyed by the file's path, size and modification time, a changed file gets a new key.
+     * Each thumbnail is one file named after its key, with the extension of its encoding (.png or .jpg).
+     * Files are written under a temporary name and renamed once complete, and the least recently
+     * used ones are removed when the cache grows over its size limit.
+     */
+    class ThumbnailCache {
+        public:
+            // Bump whenever thumbnails are made differently so old ones stop matching
+            static const uint32_t FORMAT_VERSION = 1;
+
+            static ThumbnailCache* get_instance();
+
+            /**
+             * @brief Set where thumbnails are stored, the directory is created when needed
+             */
+            void set_directory(std::string dir);
+            std::string get_directory();
+
+            /**
+             * @brief Set the most bytes of thumbnails to keep, 0 disables the cache
+             */
+            void set_size_limit(size_t bytes);
+            bool enabled();
+
+            /**
+             * @brief Read the cached thumbnail of a file
+             * @param type set to the encoding of the thumbnail, PNG or JPEG
+             * @return false if there is none for the current version of the file
+             */
+            bool load(std::string filename, std::vector<uchar>& encoded, enum output_type& type);
+
+            /**
+             * @brief Cache the thumbnail of a file, failures are ignored, it will just be extracted again
+             * @param type the encoding of the thumbnail, PNG or JPEG
+             */
+            void store(std::string filename, const std::vector<uchar>& encoded, enum output_type type);
+
+            /**
+             * @brief Remove the least recently used thumbnails until the cache fits in its size limit
+             */
+            void trim();
+
+        private:
+            ThumbnailCache();
+            // Path of the thumbnail without extension, empty if the file can't be found
+            std::string path(std::string filename);
+
+            std::mutex mutex;
+            std::string directory;
+            size_t size_limit = 0;
+    };
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <filesystem>
+#include <stdexcept>
+
+#include "TilePyramid.hpp"
+#include "ImageUtil/ColorProfiles.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "ImageUtil/Image.hpp"
+#include "ImageUtil/ImageReader/LibTiffReader.hpp"
+#include "utils/memory_tracker.hpp"
+#include "utils/metrics.hpp"
+
+namespace fs = std::filesystem;
+
+namespace btrgb {
+
+    /* ============[ TilePyramid ]============== */
+
+    TilePyramid::TilePyramid(cv::Mat srgb_8u) {
+        this->level_mats.push_back(srgb_8u);
+        while (this->level_mats.back().cols > TILE_SIZE || this->level_mats.back().rows > TILE_SIZE) {
+            const cv::Mat& above = this->level_mats.back();
+            cv::Mat level;
+            cv::resize(above, level, cv::Size((above.cols + 1) / 2, (above.rows + 1) / 2), 0, 0, cv::INTER_AREA);
+            this->level_mats.push_back(level);
+        }
+    }
+
+    int TilePyramid::levels() const {
+        return this->level_mats.size();
+    }
+
+    int TilePyramid::width(int level) const {
+        return this->level_mats.at(level).cols;
+    }
+
+    int TilePyramid::height(int level) const {
+        return this->level_mats.at(level).rows;
+    }
+
+    int TilePyramid::columns(int level) const {
+        return (this->width(level) + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    int TilePyramid::rows(int level) const {
+        return (this->height(level) + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    cv::Mat TilePyramid::tile(int level, int x, int y) const {
+        if (level < 0 || level >= this->levels() || x < 0 || x >= this->columns(level) || y < 0 || y >= this->rows(level))
+            throw std::out_of_range("[TilePyramid::tile] No such tile.");
+
+        const cv::Mat& im = this->level_mats[level];
+        cv::Rect region(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+        return im(region & cv::Rect(0, 0, im.cols, im.rows)).clone();
+    }
+
+    size_t TilePyramid::bytes() const {
+        size_t total = 0;
+        for (const cv::Mat& level : this->level_mats)
+            total += level.total() * level.elemSize();
+        return total;
+    }
+
+    /* ============[ TilePyramidCache ]============== */
+
+    TilePyramidCache* TilePyramidCache::get_instance() {
+        static TilePyramidCache instance;
+        return &instance;
+    }
+
+    void TilePyramidCache::set_memory_limit(size_t bytes) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->limit = bytes;
+        this->evict(0);
+    }
+
+    size_t TilePyramidCache::memory_limit() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->limit;
+    }
+
+    size_t TilePyramidCache::bytes() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->held_bytes;
+    }
+
+    int TilePyramidCache::entry_count() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->entries.size();
+    }
+
+    std::shared_ptr<const TilePyramid> TilePyramidCache::get(std::string filename) {
+        static Counter& hits = Metrics::counter("tilePyramids.hits");
+        static Counter& misses = Metrics::counter("tilePyramids.misses");
+
+        std::string k = key(filename);
+        if (k.empty()) {
+            misses.add();
+            return build(filename);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            // Another request is building the same pyramid, wait for it instead of building it again
+            this->built.wait(lock, [&]() { return !this->building.contains(k); });
+            auto found = this->index.find(k);
+            if (found != this->index.end()) {
+                this->entries.splice(this->entries.begin(), this->entries, found->second);
+                hits.add();
+                return found->second->pyramid;
+            }
+            this->building.insert(k);
+        }
+        misses.add();
+
+        std::shared_ptr<const TilePyramid> pyramid;
+        try {
+            pyramid = build(filename);
+        }
+        catch (...) {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->building.erase(k);
+            }
+            this->built.notify_all();
+            throw;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->insert({k, pyramid, pyramid->bytes()});
+            this->building.erase(k);
+        }
+        this->built.notify_all();
+        return pyramid;
+    }
+
+    std::shared_ptr<const TilePyramid> TilePyramidCache::build(std::string filename) {
+        // The levels belong to the cache, not to the request that happened to build them first
+        MemoryAccount::Bind unbind(nullptr);
+
+        /* The decoded pixels are shared with other requests, convert a copy. */
+        DecodedImageCache* cache = DecodedImageCache::get_instance();
+        LibTiffReader reader;
+        std::shared_ptr<const DecodedImage> decoded = cache->get(filename, DecodedImageCache::FULL, &reader);
+        cv::Mat im = decoded->bitmap.clone();
+        decoded.reset();
+
+        try {
+            std::shared_ptr<const TiffMetadata> metadata = cache->metadata(filename);
+            if (!metadata->color_profile.empty())
+                ColorProfiles::convert(im,
+                    (void*) metadata->color_profile.data(), metadata->color_profile.size(),
+                    (void*) sRGB2014_icc_data, sRGB2014_icc_size
+                );
+        } catch(const std::exception& e) {}
+
+        if (im.depth() != CV_8U)
+            im = Image::copyMatConvertDepth(im, CV_8U);
+
+        return std::make_shared<const TilePyramid>(im);
+    }
+
+    std::string TilePyramidCache::key(std::string filename) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(filename, ec);
+        if (ec)
+            return "";
+        int64_t modified = fs::last_write_time(filename, ec).time_since_epoch().count();
+        if (ec)
+            return "";
+        return std::to_string(size) + "|" + std::to_string(modified) + "|" + filename;
+    }
+
+    void TilePyramidCache::insert(Entry entry) {
+        static Gauge& held = Metrics::gauge("tilePyramids.bytes");
+        static Gauge& count = Metrics::gauge("tilePyramids.entries");
+
+        // Still handed out, just not kept
+        if (entry.bytes > this->limit || this->index.contains(entry.key))
+            return;
+
+        this->evict(entry.bytes);
+        this->held_bytes += entry.bytes;
+        this->entries.push_front(entry);
+        this->index[entry.key] = this->entries.begin();
+        held.set(this->held_bytes);
+        count.set(this->entries.size());
+    }
+
+    void TilePyramidCache::evict(size_t needed) {
+        static Counter& evictions = Metrics::counter("tilePyramids.evictions");
+        static Gauge& held = Metrics::gauge("tilePyramids.bytes");
+        static Gauge& count = Metrics::gauge("tilePyramids.entries");
+
+        while (!this->entries.empty() && this->held_bytes + needed > this->limit) {
+            Entry& oldest = this->entries.back();
+            this->held_bytes -= oldest.bytes;
+            evictions.add();
+            this->index.erase(oldest.key);
+            this->entries.pop_back();
+        }
+        held.set(this->held_bytes);
+        count.set(this->entries.size());
+    }
+
+}
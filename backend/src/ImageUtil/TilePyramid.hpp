@@ -0,0 +1,110 @@
+#ifndef BTRGB_TILE_PYRAMID_HPP
+#define BTRGB_TILE_PYRAMID_HPP
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief An image at every zoom level a viewer can show it at, split into square tiles
+     *
+     * Level 0 is the full resolution image, each level after it is half the size of the one before
+     * (rounded up), and the last level fits in a single tile. Tile (x, y) of a level covers the pixels
+     * starting at (x * TILE_SIZE, y * TILE_SIZE), tiles on the right and bottom edges may be smaller.
+     */
+    class TilePyramid {
+        public:
+            static const int TILE_SIZE = 256;
+
+            /**
+             * @param srgb_8u the full resolution image, 8 bit sRGB, the pyramid keeps it without copying
+             */
+            TilePyramid(cv::Mat srgb_8u);
+
+            int levels() const;
+            int width(int level = 0) const;
+            int height(int level = 0) const;
+            // Number of tiles across and down a level
+            int columns(int level) const;
+            int rows(int level) const;
+
+            /**
+             * @brief A continuous copy of one tile, it can be changed freely
+             * @throws std::out_of_range if there is no such tile
+             */
+            cv::Mat tile(int level, int x, int y) const;
+
+            size_t bytes() const;
+
+        private:
+            std::vector<cv::Mat> level_mats;
+    };
+
+    /**
+     * @brief Process wide cache of the tile pyramids of output images
+     *
+     * Pyramids are built the first time a tile of a file is asked for: the TIFF is decoded (through
+     * DecodedImageCache), converted to sRGB with its ICC profile and scaled down level by level.
+     * After that any tile is a crop of an 8 bit level, however large the image.
+     * Entries are keyed by the file's path, size and modification time, a rewritten file gets a new
+     * pyramid. Concurrent requests for the same file build it once, and the least recently used
+     * pyramids are evicted once the cache is over its memory limit.
+     */
+    class TilePyramidCache {
+        public:
+            static TilePyramidCache* get_instance();
+
+            /**
+             * @brief Set the most bytes of pyramids to hold, 0 disables caching (every request builds its own)
+             */
+            void set_memory_limit(size_t bytes);
+            size_t memory_limit();
+
+            /**
+             * @brief The pyramid of a TIFF, from the cache or built now and added to it
+             * @throws whatever LibTiffReader throws if the file can't be read
+             */
+            std::shared_ptr<const TilePyramid> get(std::string filename);
+
+            size_t bytes();
+            int entry_count();
+
+        private:
+            TilePyramidCache() {}
+
+            struct Entry {
+                std::string key;
+                std::shared_ptr<const TilePyramid> pyramid;
+                size_t bytes = 0;
+            };
+
+            // Empty if the file can't be found
+            static std::string key(std::string filename);
+            static std::shared_ptr<const TilePyramid> build(std::string filename);
+
+            // Called with mutex held
+            void insert(Entry entry);
+            void evict(size_t needed);
+
+            std::mutex mutex;
+            std::condition_variable built;
+            size_t limit = 0;
+            size_t held_bytes = 0;
+            // Most recently used first
+            std::list<Entry> entries;
+            std::unordered_map<std::string, std::list<Entry>::iterator> index;
+            std::unordered_set<std::string> building;
+    };
+
+}
+
+#endif
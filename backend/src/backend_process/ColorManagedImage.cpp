@@ -1,4 +1,5 @@
 #include "backend_process/ColorManagedImage.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
 
 ColorManagedImage::~ColorManagedImage() {}
 
@@ -16,18 +17,18 @@ void ColorManagedImage::run() {
         if( ! btrgb::Image::is_tiff(filename) )
             throw std::runtime_error("Image is not a tiff file");
 
-        cv::Mat im;
-        tiff_reader->open(filename);
-        tiff_reader->copyBitmapTo(im);
+        /* The decoded pixels are shared with other requests, convert a copy. */
+        btrgb::DecodedImageCache* cache = btrgb::DecodedImageCache::get_instance();
+        std::shared_ptr<const btrgb::DecodedImage> decoded = cache->get(filename, btrgb::DecodedImageCache::FULL, tiff_reader.get());
+        cv::Mat im = decoded->bitmap.clone();
 
         try {
-            void* profile;
-            uint32_t profile_size;
-            tiff_reader->getColorProfile(&profile_size, &profile);
-            btrgb::ColorProfiles::convert(im, 
-                profile, profile_size, 
-                (void*) btrgb::sRGB2014_icc_data, btrgb::sRGB2014_icc_size
-            );
+            std::shared_ptr<const btrgb::TiffMetadata> metadata = cache->metadata(filename);
+            if(!metadata->color_profile.empty())
+                btrgb::ColorProfiles::convert(im, 
+                    (void*) metadata->color_profile.data(), metadata->color_profile.size(), 
+                    (void*) btrgb::sRGB2014_icc_data, btrgb::sRGB2014_icc_size
+                );
         } catch(const std::exception& e) {}
 
 
@@ -36,8 +37,15 @@ void ColorManagedImage::run() {
         imObj.initImage(im);
         imObj.setColorProfile(btrgb::ColorSpace::sRGB);
 
-        /* Send image. */
-        this->coms_obj_m->send_binary(&imObj, btrgb::FULL);
+        /* Send image, streamed in frames if the front end asked for it. */
+        bool chunked = false;
+        try { chunked = this->process_data_m->get_bool("chunked"); }
+        catch(const ParsingError& e) {}
+
+        if(chunked)
+            this->coms_obj_m->send_image_stream(&imObj, btrgb::FULL);
+        else
+            this->coms_obj_m->send_binary(&imObj, btrgb::FULL);
 
     }
     catch(const ParsingError& e) {
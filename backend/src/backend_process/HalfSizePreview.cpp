@@ -1,5 +1,11 @@
+#include <algorithm>
+#include <atomic>
 #include <regex>
 #include "backend_process/HalfSizePreview.hpp"
+#include "ImageUtil/DecodePrefetcher.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "utils/thread_budget.hpp"
+#include "utils/thread_pool.hpp"
 
 
 HalfSizePreview::~HalfSizePreview() {}
@@ -10,73 +16,98 @@ void HalfSizePreview::run() {
     try {
         Json filenames = this->process_data_m->get_array("names");
 
-        
-        std::unique_ptr<btrgb::LibRawReader> raw_reader(new btrgb::LibRawReader(btrgb::LibRawReader::PREVIEW));
-        std::unique_ptr<btrgb::LibTiffReader> tiff_reader(new btrgb::LibTiffReader);
-        btrgb::ImageReaderStrategy* reader;
-        std::string fname;
-        bool is_tiff;
-
+        std::vector<std::string> files;
         for (int i = 0; i < filenames.get_size(); i++) {
-            try {
-                fname = filenames.string_at(i);
-                is_tiff = btrgb::Image::is_tiff(fname);
+            try { files.push_back(filenames.string_at(i)); }
+            catch(const ParsingError& e) {
+                this->report_error(this->get_process_name(), e.what());
+            }
+        }
+
+        /* The same files are likely to be submitted for processing next, decode them in the background. */
+        btrgb::DecodePrefetcher::get_instance()->prefetch(files);
+
+        /* Previews are made by at most this request's share of threads at once, each one pulling the next
+         * file when it is done. Every preview is sent as soon as it is ready, named after its file,
+         * so the frontend doesn't wait on the slowest file of the batch. send_binary keeps each
+         * preview's header and binary together when workers finish at the same time. */
+        std::atomic<int> next{0};
+        int count = files.size();
+        auto make_previews = [&]() {
+            int i;
+            while ((i = next++) < count)
+                this->_send_preview(files[i]);
+        };
+        int workers = std::min(count, btrgb::ThreadBudget::get_instance()->share());
+        btrgb::ThreadPool::TaskGroup group;
+        for (int w = 1; w < workers; w++)
+            group.run(make_previews);
+        make_previews();
+        group.wait();
+
+        this->cancel_token_m->throw_if_cancelled();
+    }
+    catch(const btrgb::OperationCancelled& e) {
+        this->coms_obj_m->send_error(e.what(), "HalfSizePreview");
+        return;
+    }
+    catch(const std::exception& e) {
+        this->coms_obj_m->send_error("[HalfSizePreview] Request failed.", "HalfSizePreview");
+        return;
+    }
 
-                /* Select image reader. */
-                if(is_tiff)
-                    reader = tiff_reader.get();
-                else
-                    reader = raw_reader.get();
+}
 
 
-                /* Open image and get Mat. */
-                reader->open(fname);
-                cv::Mat im;
-                reader->copyBitmapTo(im);
-                reader->recycle();
+void HalfSizePreview::_send_preview(std::string fname) {
+    if(this->cancel_token_m->is_cancelled())
+        return;
 
-                /* Ignore 4th channel if present. */
-                if(im.channels() == 4) {
-                    cv::Mat rg1bg2 = im;
-                    im.release();
-                    im.create(rg1bg2.rows, rg1bg2.cols, CV_MAKE_TYPE(rg1bg2.depth(), 3));
-                    int from_to[] = { 0,0, 1,1, 2,2 };
-                    cv::mixChannels( &rg1bg2, 1, &im, 1, from_to, 3);
-                }
+    try {
+        /* Get the decoded Mat, shared with other requests so it is never changed in place. */
+        std::shared_ptr<const btrgb::DecodedImage> decoded = btrgb::DecodedImageCache::get_instance()->get(
+            fname, btrgb::DecodedImageCache::PREVIEW);
+        cv::Mat im = decoded->bitmap;
+
+        /* Scale down to display size first, everything after only touches the pixels that are shown. */
+        if(im.cols > DISPLAY_WIDTH) {
+            double scaler = double(DISPLAY_WIDTH) / double(im.cols);
+            cv::Mat small;
+            cv::resize(im, small, cv::Size(), scaler, scaler, cv::INTER_AREA);
+            im = small;
+        }
 
-                /* Make sure image is bright enough. */
-                double min, max;
-                cv::minMaxIdx(im, &min, &max);
-                im.convertTo(im, CV_16U, 0xFFFF / max);
+        /* Ignore 4th channel if present. */
+        if(im.channels() == 4) {
+            cv::Mat rg1bg2 = im;
+            im.release();
+            im.create(rg1bg2.rows, rg1bg2.cols, CV_MAKE_TYPE(rg1bg2.depth(), 3));
+            int from_to[] = { 0,0, 1,1, 2,2 };
+            cv::mixChannels( &rg1bg2, 1, &im, 1, from_to, 3);
+        }
 
-                /* Wrap the Mat as an Image object. */
-                btrgb::Image imObj(fname + ".HalfSize");
-                imObj.initImage(im);
+        /* Make sure image is bright enough. */
+        double min, max;
+        cv::minMaxIdx(im, &min, &max);
+        cv::Mat bright;
+        im.convertTo(bright, CV_16U, 0xFFFF / max);
 
+        /* Wrap the Mat as an Image object. */
+        btrgb::Image imObj(fname + ".HalfSize");
+        imObj.initImage(bright);
 
-                /* Send image. */
-                this->coms_obj_m->send_binary(&imObj, btrgb::FAST);
 
+        /* Send image. */
+        this->coms_obj_m->send_binary(&imObj, btrgb::FAST);
 
-            }
-            catch(const btrgb::LibRawFileTypeUnsupported& e) {
-                this->report_error(this->get_process_name(), "File type unknown, or unsupported by LibRaw.");
-            }
-            catch(const ParsingError& e) {
-                this->report_error(this->get_process_name(), e.what());
-            }
-            catch(const std::runtime_error& e) {
-                this->report_error(this->get_process_name(), std::string(e.what()) + " (" + fname + ")");
-            }
-            catch(const btrgb::FailedToEncode& e) {
-                this->report_error(this->get_process_name(), std::string(e.what()) + " (" + fname + ")");
-            }
-            reader->recycle();
-        }
     }
-    catch(const std::exception& e) {
-        this->coms_obj_m->send_error("[HalfSizePreview] Request failed.", "HalfSizePreview");
-        return;
+    catch(const btrgb::LibRawFileTypeUnsupported& e) {
+        this->report_error(this->get_process_name(), "File type unknown, or unsupported by LibRaw.");
+    }
+    catch(const std::runtime_error& e) {
+        this->report_error(this->get_process_name(), std::string(e.what()) + " (" + fname + ")");
+    }
+    catch(const btrgb::FailedToEncode& e) {
+        this->report_error(this->get_process_name(), std::string(e.what()) + " (" + fname + ")");
     }
-
 }
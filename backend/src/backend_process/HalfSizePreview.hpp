@@ -19,6 +19,10 @@ public:
     ~HalfSizePreview();
 	void run() override;
 
+private:
+    /* Decodes, scales and sends the preview of one file, errors are reported and not thrown. */
+    void _send_preview(std::string fname);
+
 };
 
 
@@ -1,4 +1,6 @@
 #include "backend_process/SpectralPicker.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "utils/thread_pool.hpp"
 
 SpectralPicker::~SpectralPicker() {}
 
@@ -20,9 +22,10 @@ void SpectralPicker::run() {
             throw std::runtime_error("Spectral image is not a tiff file");
 
         
-        tiff_reader->open(filename);
-        int width = tiff_reader->width();
-        int height = tiff_reader->height();
+        btrgb::DecodedImageCache* cache = btrgb::DecodedImageCache::get_instance();
+        std::shared_ptr<const btrgb::TiffMetadata> metadata = cache->metadata(filename);
+        int width = metadata->width;
+        int height = metadata->height;
         int size = size_rel * width;
         int radius = size/2;
         int x = x_rel * width;
@@ -36,7 +39,26 @@ void SpectralPicker::run() {
         int top = (y - radius < 0 ? 0 : y - radius);
         int bot = (y + radius > height ? height : y + radius);
 
-        cv::Mat im = tiff_reader->getCrop(left, top, right - left, bot - top);
+        /* Picks after the first are crops of the cached pixels. The first reads only its crop
+         * from the file and loads the whole image into the cache in the background. */
+        cv::Mat im;
+        std::shared_ptr<const btrgb::DecodedImage> cached = cache->find(filename);
+        if(nullptr != cached) {
+            im = cached->bitmap(cv::Rect(left, top, right - left, bot - top));
+        }
+        else {
+            tiff_reader->open(filename);
+            im = tiff_reader->getCrop(left, top, right - left, bot - top);
+            tiff_reader->recycle();
+
+            size_t image_bytes = size_t(width) * height * metadata->channels * (metadata->depth / 8);
+            if(image_bytes <= cache->memory_limit()) {
+                btrgb::ThreadPool::get_instance()->submit([filename]() {
+                    try { btrgb::DecodedImageCache::get_instance()->get(filename); }
+                    catch(...) {}
+                });
+            }
+        }
         int channels = im.channels();
         if(channels > 16) throw std::runtime_error("Image has more than 16 channels.");
 
@@ -45,7 +67,7 @@ void SpectralPicker::run() {
 
         for (int row = 0; row < im.rows; row++) {
             for (int col = 0; col < im.cols; col++) {
-                im_pixel = (uint16_t*) im.data + row * im.cols * channels + col * channels;
+                im_pixel = im.ptr<uint16_t>(row) + col * channels;
                 for(int ch = 0; ch < channels; ch++)
                     avg[ch] += float(im_pixel[ch]);
             }
@@ -56,7 +78,9 @@ void SpectralPicker::run() {
             avg[ch] /= total_and_normalizer;
 
         cv::Mat avg_cam_sig(channels, 1, CV_32FC1, avg);
-        cv::Mat m = tiff_reader->getConversionMatrix(BTRGB_M_REFL_OPT);
+        if(!metadata->conversion_matrices.contains(BTRGB_M_REFL_OPT))
+            throw std::runtime_error("Spectral image does not have a reflectance conversion matrix.");
+        cv::Mat m = metadata->conversion_matrices.at(BTRGB_M_REFL_OPT);
         cv::Mat spectrum = m * avg_cam_sig;
 
         this->coms_obj_m->send_spectrum((float*)spectrum.data, spectrum.rows);
@@ -0,0 +1,39 @@
+#include "backend_process/StatsRequest.hpp"
+
+StatsRequest::~StatsRequest() {}
+
+void StatsRequest::run() {
+    jsoncons::json memory;
+    memory.insert_or_assign("matBytes", btrgb::MemoryTracker::current_bytes());
+    memory.insert_or_assign("peakMatBytes", btrgb::MemoryTracker::peak_bytes());
+    memory.insert_or_assign("rssBytes", btrgb::MemoryTracker::rss_bytes());
+    memory.insert_or_assign("peakRssBytes", btrgb::MemoryTracker::peak_rss_bytes());
+    memory.insert_or_assign("scratchBytes", btrgb::ScratchAllocator::get_instance()->scratch_bytes());
+
+    btrgb::ThreadBudget* budget = btrgb::ThreadBudget::get_instance();
+    jsoncons::json threads;
+    threads.insert_or_assign("total", budget->total());
+    threads.insert_or_assign("active", budget->active_count());
+    threads.insert_or_assign("share", budget->share());
+    threads.insert_or_assign("pool", btrgb::ThreadPool::get_instance()->size());
+
+    btrgb::DecodedImageCache* decoded = btrgb::DecodedImageCache::get_instance();
+    jsoncons::json decode_cache;
+    decode_cache.insert_or_assign("bytes", decoded->bytes());
+    decode_cache.insert_or_assign("limitBytes", decoded->memory_limit());
+    decode_cache.insert_or_assign("entries", decoded->entry_count());
+
+    btrgb::TilePyramidCache* pyramids = btrgb::TilePyramidCache::get_instance();
+    jsoncons::json tile_cache;
+    tile_cache.insert_or_assign("bytes", pyramids->bytes());
+    tile_cache.insert_or_assign("limitBytes", pyramids->memory_limit());
+    tile_cache.insert_or_assign("entries", pyramids->entry_count());
+
+    jsoncons::json stats = this->server_stats_m();
+    stats.insert_or_assign("memory", memory);
+    stats.insert_or_assign("threads", threads);
+    stats.insert_or_assign("decodeCache", decode_cache);
+    stats.insert_or_assign("tileCache", tile_cache);
+    stats.insert_or_assign("metrics", btrgb::Metrics::snapshot());
+    this->coms_obj_m->send_stats(stats);
+}
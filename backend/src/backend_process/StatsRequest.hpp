@@ -0,0 +1,41 @@
+#ifndef STATSREQUEST_H
+#define STATSREQUEST_H
+
+#include <functional>
+#include <jsoncons/json.hpp>
+
+#include "utils/memory_tracker.hpp"
+#include "utils/metrics.hpp"
+#include "utils/scratch_allocator.hpp"
+#include "utils/thread_budget.hpp"
+#include "utils/thread_pool.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "ImageUtil/TilePyramid.hpp"
+#include "server/comunication_obj.hpp"
+
+#include "backend_process.hpp"
+
+
+/*
+Reports what the backend is doing: every queued or running request and its stage,
+queue depth of each scheduler lane, memory use, the thread budget, the decoded image cache
+and the metrics registry
+*/
+class StatsRequest : public BackendProcess {
+
+public:
+    /*
+    @param server_stats: builds the stats of the requests and lanes, provided by the ProcessManager
+    */
+    StatsRequest(std::string name, std::function<jsoncons::json()> server_stats)
+        : BackendProcess(name), server_stats_m(server_stats) {};
+    ~StatsRequest();
+	void run() override;
+
+private:
+    std::function<jsoncons::json()> server_stats_m;
+
+};
+
+
+#endif
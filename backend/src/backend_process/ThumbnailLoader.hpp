@@ -7,6 +7,9 @@
 
 #include "backend_process.hpp"
 
+// Most pixels along the longer side of a tiff thumbnail, before display scaling
+#define THUMBNAIL_SIZE 512
+
 class ThumbnailLoader : public BackendProcess {
 
 public:
@@ -15,8 +18,10 @@ public:
 	void run() override;
 
 private:
-    void _read_raw_thumbnail(btrgb::LibRawThumbnail* reader, std::string file);
-    void _read_tiff(btrgb::LibTiffReader* reader, std::string file);
+    /* Sends the cached thumbnail of a file, extracting and caching it first if needed. */
+    void _send_thumbnail(std::string file);
+    void _read_raw_thumbnail(std::string file, std::vector<uchar>& encoded, enum btrgb::output_type& type);
+    void _read_tiff(std::string file, std::vector<uchar>& encoded, enum btrgb::output_type& type);
 };
 
 #endif
\ No newline at end of file
@@ -1,4 +1,8 @@
 #include "backend_process/ThumbnailLoader.hpp"
+#include "ImageUtil/DecodePrefetcher.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "ImageUtil/ThumbnailCache.hpp"
+#include "utils/thread_pool.hpp"
 
 ThumbnailLoader::~ThumbnailLoader() {}
 
@@ -7,33 +11,30 @@ void ThumbnailLoader::run() {
     try {
         Json filenames = this->process_data_m->get_array("names");
 
-        std::unique_ptr<btrgb::LibRawThumbnail> raw_thumbnail_reader(new btrgb::LibRawThumbnail);
-        std::unique_ptr<btrgb::LibTiffReader> tiff_reader(new btrgb::LibTiffReader);
-        std::string fname;
-
+        std::vector<std::string> files;
         for (int i = 0; i < filenames.get_size(); i++) {
-            try {
+            try { files.push_back(filenames.string_at(i)); }
+            catch(const ParsingError& e) {
+                this->coms_obj_m->send_error("[ThumbnailLoader] Invalid file name.", "ThumbnailLoader", btrgb::BENING);
+            }
+        }
 
-                fname = filenames.string_at(i);
-                if(btrgb::Image::is_tiff(fname))
-                    this->_read_tiff(tiff_reader.get(), fname);
-                else
-                    this->_read_raw_thumbnail(raw_thumbnail_reader.get(), fname);
+        /* The same files are likely to be submitted for processing next, decode them in the background. */
+        btrgb::DecodePrefetcher::get_instance()->prefetch(files);
 
-            }
-            catch(btrgb::ReaderFailedToOpenFile& e) {
-                this->coms_obj_m->send_error("Failed to open file " + fname, "ThumbnailLoader", btrgb::BENING);
-            }
-            catch(std::runtime_error& e) {
-                this->coms_obj_m->send_error(e.what(), "ThumbnailLoader", btrgb::BENING);
-            }
-            catch(...) {
-                this->coms_obj_m->send_error("[ThumbnailLoader] Unknown error.", "ThumbnailLoader", btrgb::BENING);
-            }
+        /* Thumbnails are extracted concurrently and each one is sent as soon as it is ready,
+         * so they arrive in the order they finish rather than the order they were asked for. */
+        btrgb::ThreadPool::TaskGroup group;
+        for (std::string fname : files)
+            group.run([this, fname]() { this->_send_thumbnail(fname); });
+        group.wait();
 
-            raw_thumbnail_reader->recycle();
-            tiff_reader->recycle();
-        }
+        btrgb::ThumbnailCache::get_instance()->trim();
+        this->cancel_token_m->throw_if_cancelled();
+    }
+    catch(const btrgb::OperationCancelled& e) {
+        this->coms_obj_m->send_error(e.what(), "ThumbnailLoader", btrgb::CRITICAL);
+        return;
     }
     catch(const std::exception& e) {
         this->coms_obj_m->send_error("[ThumbnailLoader] Invalid request.", "ThumbnailLoader", btrgb::CRITICAL);
@@ -43,16 +44,45 @@ void ThumbnailLoader::run() {
 }
 
 
-void ThumbnailLoader::_read_raw_thumbnail(btrgb::LibRawThumbnail* reader, std::string file) {
+void ThumbnailLoader::_send_thumbnail(std::string file) {
+    if(this->cancel_token_m->is_cancelled())
+        return;
+
+    try {
+        btrgb::ThumbnailCache* cache = btrgb::ThumbnailCache::get_instance();
+        std::vector<uchar> encoded;
+        enum btrgb::output_type type;
+
+        if( ! cache->load(file, encoded, type) ) {
+            if(btrgb::Image::is_tiff(file))
+                this->_read_tiff(file, encoded, type);
+            else
+                this->_read_raw_thumbnail(file, encoded, type);
+            cache->store(file, encoded, type);
+        }
+
+        this->coms_obj_m->send_binary(file, &encoded, type);
+    }
+    catch(btrgb::ReaderFailedToOpenFile& e) {
+        this->coms_obj_m->send_error("Failed to open file " + file, "ThumbnailLoader", btrgb::BENING);
+    }
+    catch(std::runtime_error& e) {
+        this->coms_obj_m->send_error(e.what(), "ThumbnailLoader", btrgb::BENING);
+    }
+    catch(...) {
+        this->coms_obj_m->send_error("[ThumbnailLoader] Unknown error.", "ThumbnailLoader", btrgb::BENING);
+    }
+}
+
+
+void ThumbnailLoader::_read_raw_thumbnail(std::string file, std::vector<uchar>& encoded, enum btrgb::output_type& type) {
+    std::unique_ptr<btrgb::LibRawThumbnail> reader(new btrgb::LibRawThumbnail);
     reader->open(file);
 
     if( reader->is_encoded() ) {
-
-        std::unique_ptr<std::vector<uchar>> binary(new std::vector<uchar>);
-        reader->copyBitmapTo(*binary);
+        reader->copyBitmapTo(encoded);
         reader->recycle();
-
-        this->coms_obj_m->send_binary(file, binary.get(), btrgb::JPEG);
+        type = btrgb::JPEG;
     }
     else {
         cv::Mat im;
@@ -63,27 +93,48 @@ void ThumbnailLoader::_read_raw_thumbnail(btrgb::LibRawThumbnail* reader, std::s
         btrgb::Image imObj(file);
         imObj.initImage(im);
 
-        /* Send image. */
-        this->coms_obj_m->send_binary(&imObj, btrgb::FAST);
+        encoded = *imObj.getEncodedPNG(btrgb::FAST);
+        type = btrgb::PNG;
     }
 }
 
-void ThumbnailLoader::_read_tiff(btrgb::LibTiffReader* reader, std::string file) {
-    /* Open tiff. */
-    reader->open(file);
+void ThumbnailLoader::_read_tiff(std::string file, std::vector<uchar>& encoded, enum btrgb::output_type& type) {
     cv::Mat im;
-    reader->copyBitmapTo( im );
-    reader->recycle();
+
+    /* Scale down the whole image if another request already decoded it,
+     * otherwise read only every Nth row and column of the tiff.
+     * N is rounded up so the longer side ends up at most THUMBNAIL_SIZE. */
+    std::shared_ptr<const btrgb::DecodedImage> decoded = btrgb::DecodedImageCache::get_instance()->find(file);
+    if(nullptr != decoded) {
+        int step = std::max(1, (std::max(decoded->bitmap.cols, decoded->bitmap.rows) + THUMBNAIL_SIZE - 1) / THUMBNAIL_SIZE);
+        cv::resize(decoded->bitmap, im, cv::Size(), 1.0 / step, 1.0 / step, cv::INTER_AREA);
+    }
+    else {
+        std::unique_ptr<btrgb::LibTiffReader> reader(new btrgb::LibTiffReader);
+        reader->open(file);
+        int step = std::max(1, (std::max(reader->width(), reader->height()) + THUMBNAIL_SIZE - 1) / THUMBNAIL_SIZE);
+        try {
+            im = reader->getSubsampled(step);
+        }
+        catch(const std::runtime_error& e) {
+            /* Tiled tiffs are read whole. */
+            cv::Mat full;
+            reader->copyBitmapTo(full);
+            cv::resize(full, im, cv::Size(), 1.0 / step, 1.0 / step, cv::INTER_AREA);
+        }
+        reader->recycle();
+    }
 
     /* Auto bit depth (just for displaying). */
     double min, max;
     cv::minMaxIdx(im, &min, &max);
-    im.convertTo(im, CV_8U, 0xFF / max);
+    cv::Mat im8;
+    im.convertTo(im8, CV_8U, 0xFF / max);
 
     /* Wrap the Mat as an Image object. */
     btrgb::Image imObj(file);
-    imObj.initImage(im);
+    imObj.initImage(im8);
 
-    /* Send image. */
-    this->coms_obj_m->send_binary(&imObj, btrgb::FAST);
+    encoded = *imObj.getEncodedPNG(btrgb::FAST);
+    type = btrgb::PNG;
 }
@@ -0,0 +1,61 @@
+#include "backend_process/TileRequest.hpp"
+
+TileRequest::~TileRequest() {}
+
+
+void TileRequest::run() {
+
+    try {
+        std::string prj_filename = this->process_data_m->get_string("name");
+        std::ifstream prj_file(prj_filename);
+        std::string local_file = jsoncons::json::parse(prj_file)["OutPutFiles"]["CM"].as<std::string>();
+        std::string filename = prj_filename.substr(0, prj_filename.find_last_of("/\\") + 1) + local_file;
+
+        if( ! btrgb::Image::is_tiff(filename) )
+            throw std::runtime_error("Image is not a tiff file");
+
+        /* Built on the first request for this image, a lookup after that. */
+        std::shared_ptr<const btrgb::TilePyramid> pyramid = btrgb::TilePyramidCache::get_instance()->get(filename);
+        this->coms_obj_m->send_tile_pyramid(filename, pyramid->width(), pyramid->height(),
+            pyramid->levels(), btrgb::TilePyramid::TILE_SIZE);
+
+        /* Without tiles only the layout is sent. */
+        if( ! this->process_data_m->has("tiles", Json::Type::ARRAY) )
+            return;
+
+        Json tiles = this->process_data_m->get_array("tiles");
+        for (int i = 0; i < tiles.get_size(); i++) {
+            this->cancel_token_m->throw_if_cancelled();
+            try {
+                Json t = tiles.obj_at(i);
+                int level = t.get_number("level");
+                int x = t.get_number("x");
+                int y = t.get_number("y");
+
+                /* Wrap the tile as an Image object, already sRGB. */
+                btrgb::Image imObj(filename + "/" + std::to_string(level) + "/" + std::to_string(x) + "_" + std::to_string(y));
+                imObj.initImage(pyramid->tile(level, x, y));
+                imObj.setColorProfile(btrgb::ColorSpace::sRGB);
+
+                this->coms_obj_m->send_binary(&imObj, btrgb::FAST);
+            }
+            catch(const ParsingError& e) {
+                this->coms_obj_m->send_error("Invalid tile in Tile JSON", "Tile", btrgb::BENING);
+            }
+            catch(const std::out_of_range& e) {
+                this->coms_obj_m->send_error(e.what(), "Tile", btrgb::BENING);
+            }
+        }
+
+    }
+    catch(const ParsingError& e) {
+        this->coms_obj_m->send_error("Invalid Tile JSON", "Tile");
+    }
+    catch(const btrgb::OperationCancelled& e) {
+        this->coms_obj_m->send_error(e.what(), "Tile");
+    }
+    catch(const std::exception& e) {
+        this->coms_obj_m->send_error(e.what(), "Tile");
+    }
+
+}
@@ -0,0 +1,32 @@
+#ifndef BTRGB_TILE_REQUEST_HPP
+#define BTRGB_TILE_REQUEST_HPP
+
+#include <fstream>
+#include <jsoncons/json.hpp>
+
+#include "ImageUtil/Image.hpp"
+#include "ImageUtil/TilePyramid.hpp"
+#include "utils/json.hpp"
+#include "server/comunication_obj.hpp"
+
+#include "backend_process.hpp"
+
+
+/*
+Sends tiles of a project's color managed image, for viewers that pan and zoom
+	{ "name": <project file>,
+	  "tiles": [ {"level": <int>, "x": <int>, "y": <int>}, ... ] }
+A TilePyramid message describing the levels is sent first (all that is sent without "tiles"), then each tile as an ImageBinary
+named "<image file>/<level>/<x>_<y>" (level 0 is full resolution, see TilePyramid).
+*/
+class TileRequest : public BackendProcess {
+
+public:
+    TileRequest(std::string name) : BackendProcess(name) {};
+    ~TileRequest();
+	void run() override;
+
+};
+
+
+#endif
@@ -4,4 +4,6 @@ unsigned int BackendProcess::pid = 0;
 
 BackendProcess::BackendProcess(std::string name) {
     this->name = name + " (" + std::to_string(BackendProcess::pid++) + ")";
+    this->cancel_token_m = std::make_shared<btrgb::CancellationToken>();
+    this->memory_account_m = btrgb::MemoryAccount::create(this->name);
 }
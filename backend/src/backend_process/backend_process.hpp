@@ -5,6 +5,8 @@
 #include "server/comunication_obj.hpp"
 #include "server/communicator.hpp"
 #include "utils/json.hpp"
+#include "utils/cancellation_token.hpp"
+#include "utils/memory_tracker.hpp"
 
 /*
 Abstract class representing all BackendProcess's
@@ -42,12 +44,26 @@ public:
 	*/
 	void set_process_data(Json data) { process_data_m = std::shared_ptr<Json>(new Json(data)); }
 
+	/**
+	* Get the token used to cancel this process.
+	* Calling cancel() on the token will stop the process at its next check
+	*/
+	std::shared_ptr<btrgb::CancellationToken> get_cancellation_token() { return cancel_token_m; }
+
+	/**
+	* Get the account the process's memory use is charged to.
+	* It only counts allocations made while it is bound to the thread (see MemoryAccount::Bind)
+	*/
+	std::shared_ptr<btrgb::MemoryAccount> get_memory_account() { return memory_account_m; }
+
 private:
 	static unsigned int pid;
 	std::string name = "Undefined Process";
 
 protected:
 	std::shared_ptr<Json> process_data_m;
+	std::shared_ptr<btrgb::CancellationToken> cancel_token_m;
+	std::shared_ptr<btrgb::MemoryAccount> memory_account_m;
 };
 
 #endif
@@ -5,19 +5,72 @@
 std::shared_ptr<ImgProcessingComponent> Pipeline::pipelineSetup() {
     //Set up PreProcess components
     std::vector<std::shared_ptr<ImgProcessingComponent>> pre_process_components;
-    pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new ImageReader()));
-    //pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new ChannelSelector()));
-    pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new BitDepthScaler()));
-    pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new FlatFieldor()));
-    //Sharpening and Noise Reduction
-    if(this->get_sharpen_type() != "N"){
-        pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new NoiseReduction(this->get_sharpen_type())));
-    }
-    pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new PixelRegestor(this->get_registration_type())));
+    //Stages up to the checkpoint being resumed from are replaced by a CheckpointReader
+    std::vector<uint64_t> keys = this->checkpoint_keys();
+    int resume = this->resume_checkpoint(keys);
+    std::vector<std::shared_ptr<ImgProcessingComponent>> skipped_components;
+    auto add_stage_component = [&](ImgProcessingComponent* component, int checkpoint, bool ends_stage) {
+        std::shared_ptr<ImgProcessingComponent> stage_component(component);
+        if(ends_stage && !keys.empty())
+            stage_component = std::shared_ptr<ImgProcessingComponent>(new CheckpointWriter(stage_component, keys[checkpoint]));
+        if(checkpoint > resume){
+            pre_process_components.push_back(stage_component);
+            return;
+        }
+        skipped_components.push_back(stage_component);
+        if(ends_stage && checkpoint == resume)
+            pre_process_components.push_back(std::shared_ptr<ImgProcessingComponent>(new CheckpointReader(skipped_components, keys[resume])));
+    };
+
+    bool preview = this->should_preview() || this->is_preview_only();
+    if(resume < DECODED && !preview){
+        //Each set is flat fielded while the next one is still being read
+        //The decoded checkpoint can't be saved, the white and dark images are removed set by set
+        std::shared_ptr<NoiseReduction> noise_reduction;
+        if(this->get_sharpen_type() != "N")
+            noise_reduction = std::shared_ptr<NoiseReduction>(new NoiseReduction(this->get_sharpen_type()));
+        SetStreamer* streamer = new SetStreamer(
+            std::shared_ptr<ImageReader>(new ImageReader(this->is_draft(), this->is_scratch_frames())),
+            std::shared_ptr<BitDepthScaler>(new BitDepthScaler()),
+            std::shared_ptr<FlatFieldor>(new FlatFieldor()),
+            noise_reduction);
+        add_stage_component(streamer, (nullptr != noise_reduction) ? FILTERED : FLAT_FIELDED, true);
+    }
+    else{
+        add_stage_component(new ImageReader(this->is_draft(), this->is_scratch_frames()), DECODED, false);
+        //pre_process_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new ChannelSelector()));
+        add_stage_component(new BitDepthScaler(), DECODED, true);
+        //Quick calibration on just the target region
+        if(preview){
+            std::vector<std::shared_ptr<ImgProcessingComponent>> preview_components;
+            preview_components.push_back(std::shared_ptr<ImgProcessingComponent>(new FlatFieldor()));
+            preview_components.push_back(std::shared_ptr<ImgProcessingComponent>(new PixelRegestor(this->get_registration_type())));
+            preview_components.push_back(std::shared_ptr<ImgProcessingComponent>(new ColorManagedCalibrator()));
+            std::shared_ptr<ImgProcessingComponent> preview_spectral(new SpectralCalibrator());
+            preview_components.push_back(preview_spectral);
+            std::shared_ptr<PreviewCalibrator> preview_calibrator(new PreviewCalibrator(preview_components));
+            //Both calibrations only read the registered images, run them side by side
+            preview_calibrator->set_dependencies(preview_spectral, {preview_components[1]});
+            pre_process_components.push_back(preview_calibrator);
+            //The full image pass is abandoned
+            if(this->is_preview_only()){
+                std::vector<std::shared_ptr<ImgProcessingComponent>> img_process_components;
+                img_process_components.push_back(std::shared_ptr<ImgProcessingComponent>(new PreProcessor(pre_process_components)));
+                return std::shared_ptr<ImgProcessingComponent>(new ImageProcessor(img_process_components));
+            }
+        }
+        add_stage_component(new FlatFieldor(), FLAT_FIELDED, true);
+        //Sharpening and Noise Reduction
+        if(this->get_sharpen_type() != "N"){
+            add_stage_component(new NoiseReduction(this->get_sharpen_type()), FILTERED, true);
+        }
+    }
+    add_stage_component(new PixelRegestor(this->get_registration_type()), REGISTERED, true);
     //Set up Calibration components
     std::vector<std::shared_ptr<ImgProcessingComponent>> calibration_components;
     calibration_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new ColorManagedCalibrator()));
-    calibration_components.push_back(static_cast<const std::shared_ptr <ImgProcessingComponent>>(new SpectralCalibrator()));
+    std::shared_ptr<ImgProcessingComponent> spectral_calibrator(new SpectralCalibrator());
+    calibration_components.push_back(spectral_calibrator);
    if(this->should_verify){
         calibration_components.push_back(std::shared_ptr<ImgProcessingComponent>(new Verification())) ;     
     }
@@ -25,12 +78,74 @@ std::shared_ptr<ImgProcessingComponent> Pipeline::pipelineSetup() {
  
     std::vector<std::shared_ptr<ImgProcessingComponent>> img_process_components;
     img_process_components.push_back(std::shared_ptr<ImgProcessingComponent>(new PreProcessor(pre_process_components)));
-    img_process_components.push_back(std::shared_ptr<ImgProcessingComponent>(new ImageCalibrator(calibration_components)));
+    std::shared_ptr<ImageCalibrator> calibrator(new ImageCalibrator(calibration_components));
+    //Spectral calibration doesn't use anything color managment produces, run them side by side
+    calibrator->set_dependencies(spectral_calibrator, {});
+    img_process_components.push_back(calibrator);
     
     return std::shared_ptr<ImgProcessingComponent>(new ImageProcessor(img_process_components));
 
 };
 
+std::vector<uint64_t> Pipeline::checkpoint_keys() {
+    std::vector<uint64_t> keys;
+    btrgb::CheckpointCache* cache = btrgb::CheckpointCache::get_instance();
+    if(!cache->enabled())
+        return keys;
+
+    try {
+        // Decoded: the contents of every input file and how they are read
+        uint64_t key = btrgb::CheckpointCache::hash("v" + std::to_string(btrgb::CheckpointCache::FORMAT_VERSION));
+        Json image_array = this->process_data_m->get_array(key_map[DataKey::IMAGES]);
+        for (int i = 0; i < image_array.get_size(); i++) {
+            Json obj = image_array.obj_at(i);
+            for (DataKey file_key : {DataKey::ART, DataKey::WHITE, DataKey::DARK, DataKey::TARGET_IMG}) {
+                std::string file;
+                try { file = obj.get_string(key_map[file_key]); } catch (ParsingError e) { continue; }
+                key = btrgb::CheckpointCache::hash(key_map[file_key] + std::to_string(i + 1), key);
+                key = cache->hash_file(file, key);
+            }
+        }
+        key = btrgb::CheckpointCache::hash(this->is_draft() ? "draft" : "full", key);
+        keys.push_back(key);
+
+        // Flat fielded: the W value comes from the white patch of the target
+        Json target_location = this->process_data_m->get_obj(key_map[DataKey::TargetLocation]);
+        key = btrgb::CheckpointCache::hash(target_location.to_string(), key);
+        keys.push_back(key);
+
+        // Filtered
+        key = btrgb::CheckpointCache::hash(this->get_sharpen_type(), key);
+        keys.push_back(key);
+
+        // Registered
+        key = btrgb::CheckpointCache::hash(this->get_registration_type(), key);
+        keys.push_back(key);
+    }
+    catch (const std::exception& e) {
+        // Inputs that can't be read get reported when the run gets to them
+        keys.clear();
+    }
+    return keys;
+}
+
+int Pipeline::resume_checkpoint(const std::vector<uint64_t>& keys) {
+    if(keys.empty())
+        return -1;
+
+    // The preview needs the white and dark images, they are gone after flat fielding
+    int deepest = (this->should_preview() || this->is_preview_only()) ? DECODED : REGISTERED;
+    btrgb::CheckpointCache* cache = btrgb::CheckpointCache::get_instance();
+    for (int checkpoint = deepest; checkpoint >= DECODED; checkpoint--) {
+        if(cache->contains(keys[checkpoint]))
+            return checkpoint;
+    }
+    // Hits are counted by the CheckpointReader, once the checkpoint has actually been loaded
+    static btrgb::Counter& misses = btrgb::Metrics::counter("checkpoints.misses");
+    misses.add();
+    return -1;
+}
+
 bool Pipeline::init_art_obj(btrgb::ArtObject* art_obj) {
     try {
         // Extract Image Array from request data
@@ -104,6 +219,15 @@ void Pipeline::init_general_info(btrgb::ArtObject* art_obj){
     else if(option == "L")
         option_string = "Low";
     results_obj->store_string(GI_ADVANCED_FILTERS, option_string);
+    // Store Draft mode
+    results_obj->store_string(GI_DRAFT, this->is_draft() ? "Yes" : "No");
+    // Store patch statistic
+    std::string statistic_string = "Mean";
+    if(td.statistic == PATCH_MEDIAN)
+        statistic_string = "Median";
+    else if(td.statistic == PATCH_TRIMMED_MEAN)
+        statistic_string = "Trimmed Mean (" + std::to_string(td.trim_fraction) + ")";
+    results_obj->store_string(GI_PATCH_STATISTIC, statistic_string);
 
 }
 
@@ -138,6 +262,10 @@ void Pipeline::run() {
     }
 
 
+    images->set_cancellation_token(this->cancel_token_m);
+    std::shared_ptr<btrgb::Trace> trace(new btrgb::Trace);
+    images->set_trace(trace);
+
     /* Initialize ArtObject with request data */
     this->send_info("About to init art obj...", this->get_process_name());
     try{
@@ -168,21 +296,32 @@ void Pipeline::run() {
     this->send_info( "About to execute...", this->get_process_name());
     try { 
         this->coms_obj_m->send_pipeline_components(pipeline->get_component_list());
-        pipeline->execute(this->coms_obj_m.get(), images.get());
-        std::string Pro_file = images.get()->get_results_obj(btrgb::ResultType::GENERAL)->get_string(PRO_FILE);
-        this->coms_obj_m->send_post_calibration_msg(Pro_file);
+        {
+            btrgb::TraceSpan span(trace.get(), pipeline->get_name(), "run");
+            pipeline->execute(this->coms_obj_m.get(), images.get());
+        }
+        // Nothing gets written when only the preview is run
+        if(!this->is_preview_only()) {
+            std::string Pro_file = images.get()->get_results_obj(btrgb::ResultType::GENERAL)->get_string(PRO_FILE);
+            this->coms_obj_m->send_post_calibration_msg(Pro_file);
+        }
     } catch(const ImgProcessingComponent::error& e) {
         this->report_error(e.who(), e.what());
-        return;
+    }
+    catch(const btrgb::OperationCancelled& e){
+        // Leaving run releases the ArtObject and every image it holds
+        this->report_error(this->get_process_name(), e.what());
     }
     catch(ColorTarget_MissmatchingRefData e){
         this->report_error(this->get_process_name(), e.what());
-        return;
     }catch(const std::exception& err) {
         this->report_error(this->get_process_name(), err.what());
-        return;
     }
 
+    // Written even if the run failed, it shows how far the run got
+    if(!trace->write_chrome_json(out_dir + TRACE_FILE))
+        std::cerr << "Failed to write trace to " << out_dir << std::endl;
+
 }
 
 
@@ -194,7 +333,8 @@ std::string Pipeline::get_output_directory() {
     std::string time_string = btrgb::get_time(btrgb::TimeType::MILITARY, "-");
     try {
         std::string base_dir = this->process_data_m->get_string("destinationDirectory");
-        std::string dir = base_dir + "/" + OUTPUT_PREFIX + date_string + "_" + time_string + "/";
+        std::string draft_string = this->is_draft() ? "Draft_" : "";
+        std::string dir = base_dir + "/" + OUTPUT_PREFIX + draft_string + date_string + "_" + time_string + "/";
         std::filesystem::create_directories(dir);
         return dir;
     }
@@ -245,6 +385,42 @@ std::string Pipeline::get_registration_type() {
 
 
 
+bool Pipeline::is_draft() {
+    try {
+        return this->process_data_m->get_bool("draft");
+    }
+    catch (ParsingError e) {
+    }
+    return false;
+}
+
+bool Pipeline::is_scratch_frames() {
+    try {
+        return this->process_data_m->get_bool("scratchFrames");
+    }
+    catch (ParsingError e) {
+    }
+    return false;
+}
+
+bool Pipeline::should_preview() {
+    try {
+        return this->process_data_m->get_bool("previewCalibration");
+    }
+    catch (ParsingError e) {
+    }
+    return false;
+}
+
+bool Pipeline::is_preview_only() {
+    try {
+        return this->process_data_m->get_bool("previewOnly");
+    }
+    catch (ParsingError e) {
+    }
+    return false;
+}
+
 IlluminantType Pipeline::get_illuminant_type(Json target_data) {
     // Defaults to D50
     IlluminantType type = RefData::get_illuminant("");
@@ -294,6 +470,23 @@ TargetData Pipeline::build_target_data(Json target_json){
     td.ref_base = ref_loc.get_string("name");
     td.illum_base = ref_loc.get_string("illuminants");
     td.obsv_base = ref_loc.get_number("standardObserver");
+    // Optional patch statistic, defaults to the mean
+    if (target_json.has("statistic")) {
+        std::string statistic = target_json.get_string("statistic");
+        if (statistic == "mean")
+            td.statistic = PATCH_MEAN;
+        else if (statistic == "median")
+            td.statistic = PATCH_MEDIAN;
+        else if (statistic == "trimmedMean")
+            td.statistic = PATCH_TRIMMED_MEAN;
+        else
+            throw ParsingError("statistic must be one of mean, median or trimmedMean");
+    }
+    if (target_json.has("trimFraction", Json::Type::NUMBER)) {
+        td.trim_fraction = target_json.get_number("trimFraction");
+        if (td.trim_fraction < 0 || td.trim_fraction >= 0.5)
+            throw ParsingError("trimFraction must be at least 0 and less than 0.5");
+    }
     return td;
 }
 
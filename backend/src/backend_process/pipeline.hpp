@@ -16,6 +16,10 @@
 #include "image_processing/header/ResultsProcessor.h"
 #include "image_processing/header/NoiseReduction.h"
 #include "image_processing/header/Verification.h"
+#include "image_processing/header/PreviewCalibrator.h"
+#include "image_processing/header/CheckpointReader.h"
+#include "image_processing/header/CheckpointWriter.h"
+#include "image_processing/header/SetStreamer.h"
 
 
 #include "server/comunication_obj.hpp"
@@ -65,6 +69,17 @@ class Pipeline: public BackendProcess{
 	};
 
 
+	/**
+	* Pre-processing stages that end in a checkpoint, in pipeline order
+	*/
+	enum Checkpoint {
+		DECODED,
+		FLAT_FIELDED,
+		FILTERED,
+		REGISTERED
+	};
+
+
 private:
 	bool should_verify = false; // Assume there is no verification data
 
@@ -83,6 +98,23 @@ private:
 	*/
 	std::shared_ptr<ImgProcessingComponent> pipelineSetup();
 
+	/**
+	 * @brief Get the checkpoint cache keys of each Checkpoint stage
+	 * Each key covers the contents of every input file plus every setting the stages
+	 * up to and including that one depend on.
+	 * 
+	 * @return std::vector<uint64_t> indexed by Checkpoint, empty if the cache is disabled or an input can't be read
+	 */
+	std::vector<uint64_t> checkpoint_keys();
+
+	/**
+	 * @brief Find the deepest stage with a checkpoint in the cache
+	 * 
+	 * @param keys from checkpoint_keys()
+	 * @return the Checkpoint to resume from, -1 if the run has to start from the beginning
+	 */
+	int resume_checkpoint(const std::vector<uint64_t>& keys);
+
 	/**
 	 * @brief Initialize the ArtObject. 
 	 * This will populate the art object with TargetData and the initial images it will contain
@@ -154,6 +186,33 @@ private:
 	*/
 	std::string get_registration_type();
 
+	/**
+	* @brief Check if a calibration preview on just the target region should be run
+	* before the full images are processed ("previewCalibration")
+	* @return bool, defaults to false
+	*/
+	bool should_preview();
+
+	/**
+	* @brief Check if this is a draft run ("draft")
+	* A draft run processes half resolution images so the results are provisional
+	* @return bool, defaults to false
+	*/
+	bool is_draft();
+
+	/**
+	* @brief Check if the white and dark frames should be kept in memory-mapped scratch files ("scratchFrames")
+	* Lowers peak memory for very large images at the cost of disk IO during flat fielding
+	* @return bool, defaults to false
+	*/
+	bool is_scratch_frames();
+
+	/**
+	* @brief Check if only the calibration preview should be run and the full image pass abandoned ("previewOnly")
+	* @return bool, defaults to false
+	*/
+	bool is_preview_only();
+
 
 public:
 	Pipeline(std::string name) : BackendProcess(name) {};
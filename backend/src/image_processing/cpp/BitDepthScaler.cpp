@@ -13,33 +13,46 @@ void BitDepthScaler::execute(CommunicationObj* comms, btrgb::ArtObject* images)
     double count = 0;
     comms->send_progress(0, this->get_name());
     for(const auto& [key, im] : *images) {
-        int raw_bd = *(im->_raw_bit_depth);
+        images->check_cancelled();
+        this->_scale(comms, im);
+        count++;
+        comms->send_progress(count/total, this->get_name());
+    }
 
-        /* Output message. */
-        std::stringstream out3;
-        comms->send_info(out3.str(), this->get_name());
-        out3 << "Scaling \"" << im->getName() << "\" from " << raw_bd << " to 16 bits...";
+}
 
+void BitDepthScaler::scale_set(CommunicationObj* comms, btrgb::ArtObject* images, int set) {
+    std::string num = std::to_string(set);
+    for(std::string key : {"art" + num, "white" + num, "dark" + num, "target" + num}) {
+        if(!images->imageExists(key))
+            continue;
+        images->check_cancelled();
+        this->_scale(comms, images->getImage(key));
+    }
+}
 
-        /* If the bit depth is invalid or already 16 bits: skip, do not scale anything. */
-        if (raw_bd < 16 && raw_bd >= 8) {
+void BitDepthScaler::_scale(CommunicationObj* comms, btrgb::Image* im) {
+    int raw_bd = *(im->_raw_bit_depth);
 
-            /* Math:
-            * scaler = (2^16 - 1) / (2^bit_depth - 1)
-            *
-            * The value of two to any power can be performed with bit shifting:
-            * 2^x = 1 << x
-            */
-            float scaler = float( (1 << 16) - 1 ) / float( (1 << raw_bd) - 1);
+    /* Output message. */
+    std::stringstream out3;
+    comms->send_info(out3.str(), this->get_name());
+    out3 << "Scaling \"" << im->getName() << "\" from " << raw_bd << " to 16 bits...";
 
-            /* Multiply each element in matrix by the scaler. */
-            im->getMat() *= scaler;
-        }
 
+    /* If the bit depth is invalid or already 16 bits: skip, do not scale anything. */
+    if (raw_bd < 16 && raw_bd >= 8) {
 
-        count++;
-        comms->send_progress(count/total, this->get_name());
-    }
+        /* Math:
+        * scaler = (2^16 - 1) / (2^bit_depth - 1)
+        *
+        * The value of two to any power can be performed with bit shifting:
+        * 2^x = 1 << x
+        */
+        float scaler = float( (1 << 16) - 1 ) / float( (1 << raw_bd) - 1);
 
+        /* Multiply each element in matrix by the scaler. */
+        im->getMat() *= scaler;
+        im->pixelsChanged();
+    }
 }
-
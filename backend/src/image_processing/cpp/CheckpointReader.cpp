@@ -0,0 +1,36 @@
+#include "../header/CheckpointReader.h"
+
+CheckpointReader::CheckpointReader(const std::vector<std::shared_ptr<ImgProcessingComponent>>& components, uint64_t key)
+    : CompositComponent("Resuming") {
+        this->init_components(components);
+        this->key = key;
+}
+
+void CheckpointReader::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
+    comms->send_info("Loading images from the last run...", this->get_name());
+    comms->send_progress(0, this->get_name());
+
+    static btrgb::Counter& hits = btrgb::Metrics::counter("checkpoints.hits");
+    static btrgb::Counter& misses = btrgb::Metrics::counter("checkpoints.misses");
+    if (btrgb::CheckpointCache::get_instance()->load(this->key, images)) {
+        hits.add();
+    }
+    else {
+        misses.add();
+        comms->send_info("Checkpoint could not be read, processing from the start", this->get_name());
+        double count = 0;
+        double total = this->components.size();
+        this->execute_components(comms, images, [&](const std::shared_ptr<ImgProcessingComponent>& component){
+            count++;
+            comms->send_progress(count / total, this->get_name());
+        });
+    }
+
+    comms->send_progress(1, this->get_name());
+}
+
+jsoncons::json CheckpointReader::get_component_list() {
+    jsoncons::json json;
+    json.insert_or_assign("name", this->get_name());
+    return json;
+}
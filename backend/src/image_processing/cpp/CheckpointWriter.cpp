@@ -0,0 +1,24 @@
+#include "../header/CheckpointWriter.h"
+
+CheckpointWriter::CheckpointWriter(std::shared_ptr<ImgProcessingComponent> component, uint64_t key)
+    : ImgProcessingComponent(component->get_name()) {
+        this->component = component;
+        this->key = key;
+}
+
+void CheckpointWriter::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
+    this->component->execute(comms, images);
+
+    // GeneralInfo the pre-processing stages store, it has to come back with the images
+    static const std::vector<std::string> result_keys = {GI_MAKE, GI_MODEL, GI_Y, GI_W};
+    try {
+        btrgb::CheckpointCache::get_instance()->save(this->key, images, result_keys);
+    }
+    catch (const btrgb::CheckpointError& e) {
+        comms->send_info(std::string("Checkpoint not saved: ") + e.what(), this->get_name());
+    }
+}
+
+jsoncons::json CheckpointWriter::get_component_list() {
+    return this->component->get_component_list();
+}
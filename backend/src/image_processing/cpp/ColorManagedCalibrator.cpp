@@ -41,13 +41,19 @@ void ColorManagedCalibrator::execute(CommunicationObj* comms, btrgb::ArtObject*
 
     // Fined M and Offsets to minimize deltaE
     std::cout << "Optimizing to minimize deltaE" << std::endl;
-    this->find_optimization();
+    {
+        btrgb::TraceSpan span(images->get_trace(), "CM Optimization");
+        this->find_optimization();
+    }
     comms->send_progress(0.6, this->get_name());
+    images->check_cancelled();
 
     // Use M and Offsets to convert the 6 channel image to a 3 channel ColorManaged image
     std::cout << "Converting 6 channels to ColorManaged RGB image." << std::endl;
     try {
+        btrgb::TraceSpan span(images->get_trace(), "CM Apply");
         this->update_image(images);
+        span.set_pixels(int64_t(art1->width()) * art1->height());
     }
     catch(const std::exception& e) {
        throw ImgProcessingComponent::error(e.what(), this->get_name());
@@ -118,8 +124,50 @@ void ColorManagedCalibrator::update_image(btrgb::ArtObject* images){
     btrgb::Image* art2 = images->getImage("art2");
     btrgb::Image* art[2] = {art1, art2};
     int height = art1->height();
-    int width = art1->width();
+    CalibrationResults *results_obj = images->get_results_obj(btrgb::ResultType::GENERAL);
+    cv::Mat result_im;
+
+    if(GlobalsSinglton::get_instance()->float_calibration()){
+        // Apply M and the offsets directly to each pixel in single precision
+        // this avoids building the 6xN camra_sigs matrix and the 3xN result in double
+        result_im = btrgb::calibration::apply_calibration_float(art, 2, this->M, this->offest);
+        double max_deviation = btrgb::calibration::validate_calibration_float(art, 2, this->M, this->offest, result_im);
+        std::cout << "Float apply max deviation from double (16 bit code values): " << max_deviation << std::endl;
+        results_obj->store_string(GI_CM_PRECISION, "float");
+        results_obj->store_double(GI_CM_MAX_DEVIATION, max_deviation);
+    }
+    else{
+        result_im = this->apply_double(art, height);
+        results_obj->store_string(GI_CM_PRECISION, "double");
+        results_obj->store_double(GI_CM_MAX_DEVIATION, 0);
+    }
+
+    /* Convert from XYZ to target color space and clip. */
+    btrgb::ColorProfiles::convert_to_color(result_im, this->color_space);
+
+    /* Apply nonlinearity of the target color space. */
+    btrgb::ColorProfiles::apply_gamma(result_im, this->color_space);
+
+    
+    std::string name = CM_IMAGE_KEY;
+    /* Wrap in Image object for storing in the ArtObject. */
+    btrgb::Image* cm_im = new btrgb::Image(name);
+    cm_im->initImage(result_im);
+    cm_im->setColorProfile(this->color_space);
+    cm_im->setExifTags(art1->getExifTags());
+    cm_im->setConversionMatrix(BTRGB_M_OPT, this->M);
+    cm_im->setConversionMatrix(BTRGB_OFFSET_OPT, this->offest);
+
+    /* Store in ArtObject and output. */
+    images->setImage(name, cm_im);
+    
+    // Store img size in GeneralInfo
+    results_obj->store_int(GI_IMG_ROWS, cm_im->getMat().rows);
+    results_obj->store_int(GI_IMG_COLS, cm_im->getMat().cols);
 
+}
+
+cv::Mat ColorManagedCalibrator::apply_double(btrgb::Image* art[], int height){
     // Initialize 6xN Matrix to represen our 6 channal image
     // Each row represents a single channel and N is the number total pixles for each channel
     cv::Mat camra_sigs = btrgb::calibration::build_camra_signals_matrix(art, 2, 6, &this->offest);
@@ -152,31 +200,7 @@ void ColorManagedCalibrator::update_image(btrgb::ArtObject* images){
     cv::Mat result_im = cm_XYZ.t();
     result_im = result_im.reshape(3, height);
     result_im.convertTo(result_im, CV_32F);
-
-    /* Convert from XYZ to target color space and clip. */
-    btrgb::ColorProfiles::convert_to_color(result_im, this->color_space);
-
-    /* Apply nonlinearity of the target color space. */
-    btrgb::ColorProfiles::apply_gamma(result_im, this->color_space);
-
-    
-    std::string name = CM_IMAGE_KEY;
-    /* Wrap in Image object for storing in the ArtObject. */
-    btrgb::Image* cm_im = new btrgb::Image(name);
-    cm_im->initImage(result_im);
-    cm_im->setColorProfile(this->color_space);
-    cm_im->setExifTags(art1->getExifTags());
-    cm_im->setConversionMatrix(BTRGB_M_OPT, this->M);
-    cm_im->setConversionMatrix(BTRGB_OFFSET_OPT, this->offest);
-
-    /* Store in ArtObject and output. */
-    images->setImage(name, cm_im);
-    
-    // Store img size in GeneralInfo
-    CalibrationResults *results_obj = images->get_results_obj(btrgb::ResultType::GENERAL);
-    results_obj->store_int(GI_IMG_ROWS, cm_im->getMat().rows);
-    results_obj->store_int(GI_IMG_COLS, cm_im->getMat().cols);
-
+    return result_im;
 }
 
 void ColorManagedCalibrator::output_report_data(btrgb::ArtObject* images){
@@ -1,56 +1,67 @@
 #include "../header/FlatFieldor.h"
 #include <iostream>
+#include "utils/thread_pool.hpp"
 #include <boost/range/irange.hpp>
 
 void FlatFieldor::execute(CommunicationObj* comms, btrgb::ArtObject* images)
 {
-    btrgb::Image* art1;
-    btrgb::Image* art2;
-    btrgb::Image* white1;
-    btrgb::Image* white2;
-    btrgb::Image* dark1;
-    btrgb::Image* dark2;
-    btrgb::Image* target1;
-    btrgb::Image* target2;
-    RefData* reference;
+    comms->send_info("", this->get_name());
+    comms->send_progress(0, this->get_name());
 
-    bool target_found = false;
+    //Calculate w value, the pixel operation of every set uses it
+    this->calculateW(images);
 
+    //Perform flatfielding and dead pixel cleanup
+    //Each set only reads its own white and dark image so both sets are done at the same time
+    btrgb::ThreadPool::TaskGroup group;
+    group.run([&]() { this->flatFieldImages(images, 1); });
+    group.run([&]() { this->flatFieldImages(images, 2); });
+    group.wait();
+    comms->send_progress(0.9, this->get_name());
 
-    comms->send_info("", this->get_name());
-    comms->send_progress(0, this->get_name());
+    // Store Results
+    this->store_results(images);
 
-    // Pull the images needed out of the Art Object
-    try
-    {
-        art1 = images->getImage("art1");
-        art2 = images->getImage("art2");
-        white1 = images->getImage("white1");
-        dark1 = images->getImage("dark1");
-        white2 = images->getImage("white2");
-        dark2 = images->getImage("dark2");
-        reference = images->get_refrence_data();
-        try {
-            target1 = images->getImage(TARGET(1));
-            target2 = images->getImage(TARGET(2));
-            target_found = true;
-        }
-        catch (const btrgb::ArtObj_ImageDoesNotExist& e){
+    //Removes the white and dark images from the art object
+    images->deleteImage("white1");
+    images->deleteImage("white2");
+    images->deleteImage("dark1");
+    images->deleteImage("dark2");
 
-            target_found = false;
-        }
 
-    }
-    catch (const btrgb::ArtObj_ImageDoesNotExist& e)
-    {
-        throw ImgProcessingComponent::error(e.what(), this->get_name());
+
+    comms->send_progress(1, this->get_name());
+    // Outputs TIFFs for each image group for after this step, temporary
+    // images->outputImageAs(btrgb::TIFF, "art1", "art1_ff");
+    // images->outputImageAs(btrgb::TIFF, "art2", "art2_ff");
+}
+
+/**
+* Flatfields one capture set and removes its white and dark images from the art object right after
+* The w value comes from set 1 so set 1 has to be done first
+* @param set: the number of the set
+*/
+void FlatFieldor::flat_field_set(CommunicationObj* comms, btrgb::ArtObject* images, int set)
+{
+    if (set == 1) {
+        this->calculateW(images);
+        this->store_results(images);
     }
 
-    // Set up variables for the overall size of all the images, they are all the same size
-    int height = art1->height();
-    int width = art1->width();
-    int channels = art1->channels();
+    this->flatFieldImages(images, set);
+
+    std::string num = std::to_string(set);
+    images->deleteImage("white" + num);
+    images->deleteImage("dark" + num);
+}
 
+/**
+* Calculates the w value from the white patch of the target in art1/target1 and white1
+* @param images: the ArtObject holding the images
+*/
+void FlatFieldor::calculateW(btrgb::ArtObject* images)
+{
+    RefData* reference = images->get_refrence_data();
     ColorTarget target = images->get_target(TARGET(1), btrgb::TargetType::GENERAL_TARGET);
 
 
@@ -67,78 +78,52 @@ void FlatFieldor::execute(CommunicationObj* comms, btrgb::ArtObject* images)
 
     //Calculate w value and complete the pixel operation with set w value
     wCalc(patAvg, whiteAvg, yVal);
+}
 
+/**
+* Runs the pixel operation on the art image of a set, and on its target image if there is a seperate one
+* @param images: the ArtObject holding the images
+* @param set: the number of the set
+*/
+void FlatFieldor::flatFieldImages(btrgb::ArtObject* images, int set)
+{
+    std::string num = std::to_string(set);
+    btrgb::Image* art;
+    btrgb::Image* white;
+    btrgb::Image* dark;
+    btrgb::Image* target = nullptr;
 
-    //Perform flatfielding and dead pixel cleanup
-
-
-    //Image set 1-----------------------------------------------------------
-    std::unique_ptr<btrgb::Image> art1copy(new btrgb::Image("art1copy"));
-    cv::Mat copy = btrgb::Image::copyMatConvertDepth(art1->getMat(), CV_32F);
-    art1copy->initImage(copy);
-
-    pixelOperation(height, width, channels, art1, white1, dark1, art1copy.get());
-    comms->send_progress(0.5, this->get_name());
-
-    art1copy.reset(nullptr);
-
-
-    //Image set 2-----------------------------------------------------------
-    std::unique_ptr<btrgb::Image> art2copy(new btrgb::Image("art2copy"));
-    cv::Mat copy2 = btrgb::Image::copyMatConvertDepth(art2->getMat(), CV_32F);
-    art2copy->initImage(copy2);
-
-    pixelOperation(height, width, channels, art2, white2, dark2, art2copy.get());
-    comms->send_progress(1, this->get_name());
-
-    art2copy.reset(nullptr);
-
-
-    //If there are seperate targets needs to copy to do dead pixel detection
-    if (target_found) {
-
-
-        height = target1->height();
-        width = target1->width();
-        channels = target1->channels();
-
-
-        //Copy and delete instantly after operation
-        std::unique_ptr<btrgb::Image> target1copy(new btrgb::Image("target1copy"));
-        cv::Mat tcopy = btrgb::Image::copyMatConvertDepth(target1->getMat(), CV_32F);
-        target1copy->initImage(tcopy);
-
-        pixelOperation(height, width, channels, target1, white1, dark1, target1copy.get());
-
-        target1copy.reset(nullptr);
-
-
-        //Copy and delete instantly after operation
-         std::unique_ptr<btrgb::Image> target2copy(new btrgb::Image("target2copy"));
-        cv::Mat tcopy2 = btrgb::Image::copyMatConvertDepth(target2->getMat(), CV_32F);
-        target2copy->initImage(tcopy2);
-
-        pixelOperation(height, width, channels, target2, white2, dark2, target2copy.get());
-
-        target2copy.reset(nullptr);
-
+    // Pull the images needed out of the Art Object
+    try
+    {
+        art = images->getImage("art" + num);
+        white = images->getImage("white" + num);
+        dark = images->getImage("dark" + num);
+        if (images->imageExists("target" + num))
+            target = images->getImage("target" + num);
+    }
+    catch (const btrgb::ArtObj_ImageDoesNotExist& e)
+    {
+        throw ImgProcessingComponent::error(e.what(), this->get_name());
     }
 
-    // Store Results
-    this->store_results(images);
-
-    //Removes the white and dark images from the art object
-    images->deleteImage("white1");
-    images->deleteImage("white2");
-    images->deleteImage("dark1");
-    images->deleteImage("dark2");
+    auto flat_field = [this, images, white, dark](btrgb::Image* im) {
+        //Copy and delete instantly after operation
+        std::unique_ptr<btrgb::Image> imcopy(new btrgb::Image(im->getName() + "copy"));
+        cv::Mat copy = btrgb::Image::copyMatConvertDepth(im->getMat(), CV_32F);
+        imcopy->initImage(copy);
 
+        pixelOperation(im->height(), im->width(), im->channels(), im, white, dark, imcopy.get(), images);
 
+        imcopy.reset(nullptr);
+    };
 
-    comms->send_progress(1, this->get_name());
-    // Outputs TIFFs for each image group for after this step, temporary
-    // images->outputImageAs(btrgb::TIFF, "art1", "art1_ff");
-    // images->outputImageAs(btrgb::TIFF, "art2", "art2_ff");
+    //If there is a seperate target it is done at the same time as the art image
+    btrgb::ThreadPool::TaskGroup group;
+    if (nullptr != target)
+        group.run([&]() { flat_field(target); });
+    flat_field(art);
+    group.wait();
 }
 
 /**
@@ -163,16 +148,20 @@ void::FlatFieldor::wCalc(float pAvg, float wAvg, double yRef) {
 * @param wh2: white2 image
 * @param d1: dark1 image
 * @param d2 : dark2 image
+* @param images: the ArtObject the images belong to, checked for cancellation every row
 */
-void::FlatFieldor::pixelOperation(int h, int wid, int c, btrgb::Image* a, btrgb::Image* wh, btrgb::Image* d, btrgb::Image* ac) {
+void::FlatFieldor::pixelOperation(int h, int wid, int c, btrgb::Image* a, btrgb::Image* wh, btrgb::Image* d, btrgb::Image* ac, btrgb::ArtObject* images) {
     //For loop is for every pixel in the image, and gets a corrisponding pixel from white and dark images
     //Every Channel value for each pixel needs to be adjusted based on the w for that group of images
     int currRow, currCol, ch;
     int stuckPixelCounter = 0;
     int uncorrectedCounter = 0;
+    btrgb::TraceSpan span(images->get_trace(), "Flat Field Pass");
+    span.set_pixels(int64_t(h) * wid);
 
     double wPix, dPix, aPix, newPixel;
     for (currRow = 0; currRow < h; currRow++) {
+        images->check_cancelled();
         for (currCol = 0; currCol < wid; currCol++) {
             for (ch = 0; ch < c; ch++) {
 
@@ -255,6 +244,8 @@ void::FlatFieldor::pixelOperation(int h, int wid, int c, btrgb::Image* a, btrgb:
             }
         }
     }
+    // Any cached patch statistics for a are now stale
+    a->pixelsChanged();
     int corrected = stuckPixelCounter - uncorrectedCounter;
     std::cout << "Stuck/Dead Pixels Detected - " << stuckPixelCounter / 3 << "\n";
     std::cout << "Stuck/Dead Pixels Corrected - " << corrected / 3 << "\n";
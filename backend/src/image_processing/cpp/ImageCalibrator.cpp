@@ -12,12 +12,13 @@ void ImageCalibrator::execute(CommunicationObj* comms, btrgb::ArtObject* images)
     comms->send_info("Starting Image Calibration", "Image Calibration");
     double count = 0;
     double total = this->components.size();
-    for(auto  & component : this->components){
-        double currProgress = count / total;
-        comms->send_progress(currProgress, this->get_name());
-        component->execute(comms, images);
-        comms->send_binary(images->getImage("ColorManaged"), btrgb::FAST);
+    comms->send_progress(0, this->get_name());
+    this->execute_components(comms, images, [&](const std::shared_ptr<ImgProcessingComponent>& component){
         count++;
-    }
+        comms->send_progress(count / total, this->get_name());
+        // Spectral calibration may finish before color managment when they run side by side
+        if(images->imageExists("ColorManaged"))
+            comms->send_binary(images->getImage("ColorManaged"), btrgb::FAST);
+    });
     comms->send_info("Image Calibration Done!!!", this->get_name());
 }
@@ -8,11 +8,10 @@ void ImageProcessor::execute(CommunicationObj* comms, btrgb::ArtObject* images)
     comms->send_info("Starting Image Processor", this->get_name());
     double count = 0;
     double total = this->components.size();
-    for(auto  & component : this->components){
-        double currProgress = count / total;
-        comms->send_progress(currProgress, this->get_name());
-        component->execute(comms, images);
+    comms->send_progress(0, this->get_name());
+    this->execute_components(comms, images, [&](const std::shared_ptr<ImgProcessingComponent>& component){
         count++;
-    }
+        comms->send_progress(count / total, this->get_name());
+    });
     comms->send_info("Image Processing Done!!!", this->get_name());
 }
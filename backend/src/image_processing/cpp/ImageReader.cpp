@@ -1,14 +1,17 @@
 #include <string>
 
 #include "ImageUtil/Image.hpp"
-#include "ImageUtil/BitDepthFinder.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
 #include "ImageUtil/ImageReader/LibRawReader.hpp"
 #include "ImageUtil/ImageReader/TiffReaderOpenCV.hpp"
 #include "ImageUtil/ImageReader/LibTiffReader.hpp"
 #include "image_processing/header/ImageReader.h"
 
 
-ImageReader::ImageReader() : LeafComponent("Reading") {}
+ImageReader::ImageReader(bool draft, bool scratch_frames) : LeafComponent("Reading") {
+    this->_draft = draft;
+    this->_scratch_frames = scratch_frames;
+}
 
 ImageReader::~ImageReader() {
     delete this->_reader;
@@ -28,7 +31,7 @@ void ImageReader::_set_strategy(reader_strategy strategy) {
 
     switch(strategy) {
         case TIFF_OpenCV:   this->_reader = new btrgb::TiffReaderOpenCV; break;
-        case RAW_LibRaw:    this->_reader = new btrgb::LibRawReader; break;
+        case RAW_LibRaw:    this->_reader = new btrgb::LibRawReader(this->_draft ? btrgb::LibRawReader::DRAFT : btrgb::LibRawReader::UNPROCESSED); break;
         case TIFF_LibTiff:  this->_reader = new btrgb::LibTiffReader; break;
         default: throw std::logic_error("[ImageReader] Invalid strategy.");
     }
@@ -41,82 +44,114 @@ void ImageReader::_set_strategy(reader_strategy strategy) {
 void ImageReader::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
     comms->send_info("Reading In Raw Image Data!", this->get_name());
 
-    btrgb::BitDepthFinder util;
-    std::shared_ptr<int> bit_depth(new int(-1));
+    this->_bit_depth = std::shared_ptr<int>(new int(-1));
 
     double total = images->imageCount();
     double count = 0;
     comms->send_progress(0, this->get_name());
     for(const auto& [key, im] : *images) {
+        images->check_cancelled();
         comms->send_info("Loading " + im->getName() + "...", this->get_name());
+        this->_read(key, im, images);
+        count++;
+        comms->send_progress(count/total, this->get_name());
+    }
+    
+    comms->send_progress(1, this->get_name());
+
+}
 
-        /* Initialize image reader. */
-        if(btrgb::Image::is_tiff(im->getName()))
-            this->_set_strategy(TIFF_LibTiff);
-        else
-            this->_set_strategy(RAW_LibRaw);
+void ImageReader::read_set(CommunicationObj* comms, btrgb::ArtObject* images, int set) {
+    if(set == 1)
+        this->_bit_depth = std::shared_ptr<int>(new int(-1));
 
-        try {
-            cv::Mat raw_im;
+    std::string num = std::to_string(set);
+    for(std::string key : {"art" + num, "white" + num, "dark" + num, "target" + num}) {
+        if(!images->imageExists(key))
+            continue;
+        images->check_cancelled();
+        btrgb::Image* im = images->getImage(key);
+        comms->send_info("Loading " + im->getName() + "...", this->get_name());
+        this->_read(key, im, images);
+    }
+}
 
-            _reader->open(im->getName());
-            _reader->copyBitmapTo(raw_im);
-            btrgb::exif tags = _reader->getExifData(); 
-            _reader->recycle();
+void ImageReader::_read(std::string key, btrgb::Image* im, btrgb::ArtObject* images) {
+    std::shared_ptr<int> bit_depth = this->_bit_depth;
+
+    /* Initialize image reader. */
+    if(btrgb::Image::is_tiff(im->getName()))
+        this->_set_strategy(TIFF_LibTiff);
+    else
+        this->_set_strategy(RAW_LibRaw);
+
+    try {
+        cv::Mat raw_im;
+        btrgb::exif tags;
+        std::shared_ptr<const btrgb::DecodedImage> decoded;
+        {
+            btrgb::TraceSpan span(images->get_trace(), "Read " + key, "io");
+
+            /* Decoded files are shared with previews and earlier runs through the cache,
+             * files shown in a preview were likely decoded in the background already.
+             * raw_im shares the cached pixels so it is only ever read from. */
+            btrgb::DecodedImageCache::Mode mode = btrgb::DecodedImageCache::FULL;
+            if(this->_draft && this->_current_strategy == RAW_LibRaw)
+                mode = btrgb::DecodedImageCache::DRAFT;
+            decoded = btrgb::DecodedImageCache::get_instance()->get(im->getName(), mode, _reader);
+            raw_im = decoded->bitmap;
+            tags = decoded->tags;
+            span.set_pixels(raw_im.total());
+            span.set_bytes(int64_t(raw_im.total()) * raw_im.elemSize());
+        }
 
 
-            if(raw_im.depth() != CV_16U)
-                throw std::runtime_error(" Image must be 16 bit." );
-
-
-            /* Find bit depth if image is white field #1. */
-            if(key == "white1") {
-        
-                *bit_depth = util.get_bit_depth(
-                    (uint16_t*) raw_im.data,    
-                    raw_im.cols, 
-                    raw_im.rows,
-                    raw_im.channels()
-                );
-
-                if(*bit_depth < 0)
-                    throw std::runtime_error(" Bit depth detection of 'white1' failed." );
-
-                CalibrationResults* r = images->get_results_obj(btrgb::ResultType::GENERAL);
-                r->store_string(GI_MAKE, tags.make);
-                r->store_string(GI_MODEL, tags.model);
-            }
-
-            /* Convert to floating point. */
-            cv::Mat float_im;
-            raw_im.convertTo(float_im, CV_32F, 1.0/0xFFFF);
-
-            /* If there are four channels, assume the 2nd & 4th channels
-             * are both greens and average them. */
-            cv::Mat result_im;
-            if( float_im.channels() == 4 )
-                this->_average_greens(float_im, result_im);
-            else 
-                result_im = float_im;
-
-            /* Init btrgb::Image object. */
-            im->initImage(result_im);
-            im->_raw_bit_depth = bit_depth;
-            im->setExifTags(tags);
-            
-            count++;
-            comms->send_progress(count/total, this->get_name());
+        if(raw_im.depth() != CV_16U)
+            throw std::runtime_error(" Image must be 16 bit." );
 
-        }
-        catch(const std::exception& e) {
-            throw ImgProcessingComponent::error(std::string(e.what()) + " (" + im->getName() + ")", this->get_name());
+
+        /* Find bit depth if image is white field #1. */
+        if(key == "white1") {
+    
+            /* Found once per decoded file, prefetching finds it ahead of time. */
+            *bit_depth = decoded->bit_depth();
+
+            if(*bit_depth < 0)
+                throw std::runtime_error(" Bit depth detection of 'white1' failed." );
+
+            CalibrationResults* r = images->get_results_obj(btrgb::ResultType::GENERAL);
+            r->store_string(GI_MAKE, tags.make);
+            r->store_string(GI_MODEL, tags.model);
         }
 
+        /* LibRaw already decoded at half size in draft mode, TIFFs need to be scaled down.
+         * Done after bit depth detection since averaging pixels can change the bit depth found. */
+        if(this->_draft && this->_current_strategy != RAW_LibRaw)
+            cv::resize(raw_im, raw_im, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+
+        /* Convert to floating point. */
+        cv::Mat float_im;
+        raw_im.convertTo(float_im, CV_32F, 1.0/0xFFFF);
+
+        /* If there are four channels, assume the 2nd & 4th channels
+         * are both greens and average them. */
+        cv::Mat result_im;
+        if( float_im.channels() == 4 )
+            this->_average_greens(float_im, result_im);
+        else 
+            result_im = float_im;
+
+        /* Init btrgb::Image object. */
+        if(this->_scratch_frames && (key.starts_with("white") || key.starts_with("dark")))
+            im->setScratchBacked(true);
+        im->initImage(result_im);
+        im->_raw_bit_depth = bit_depth;
+        im->setExifTags(tags);
 
     }
-    
-    comms->send_progress(1, this->get_name());
-
+    catch(const std::exception& e) {
+        throw ImgProcessingComponent::error(std::string(e.what()) + " (" + im->getName() + ")", this->get_name());
+    }
 }
 
 
@@ -3,6 +3,7 @@
 //
 #include "ImageUtil/Image.hpp"
 #include "../header/NoiseReduction.h"
+#include "utils/thread_pool.hpp"
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 using namespace cv;
@@ -31,11 +32,20 @@ void NoiseReduction::execute(CommunicationObj* comms, btrgb::ArtObject* images)
         targets_found = false;
     }
 
-    this->apply_filter(img1, img2);
-
+    //The art and target images are filtered at the same time
+    btrgb::ThreadPool::TaskGroup group;
     if (targets_found) {
-        this->apply_filter(target1, target2);
+        group.run([&]() {
+            images->check_cancelled();
+            btrgb::TraceSpan span(images->get_trace(), "Filter Target");
+            this->apply_filter(target1, target2);
+        });
+    }
+    {
+        btrgb::TraceSpan span(images->get_trace(), "Filter Art");
+        this->apply_filter(img1, img2);
     }
+    group.wait();
 
     comms->send_progress(1, this->get_name());
     //Output sharpened image
@@ -44,9 +54,32 @@ void NoiseReduction::execute(CommunicationObj* comms, btrgb::ArtObject* images)
 
 }
 
+void NoiseReduction::filter_set(CommunicationObj* comms, btrgb::ArtObject* images, int set) {
+    std::string num = std::to_string(set);
+
+    //The art and target image are filtered at the same time
+    btrgb::ThreadPool::TaskGroup group;
+    if (images->imageExists("target" + num)) {
+        btrgb::Image* target = images->getImage("target" + num);
+        group.run([&, target]() {
+            btrgb::TraceSpan span(images->get_trace(), "Filter Target");
+            this->apply_filter(target);
+        });
+    }
+    {
+        btrgb::TraceSpan span(images->get_trace(), "Filter Art");
+        this->apply_filter(images->getImage("art" + num));
+    }
+    group.wait();
+}
+
 void NoiseReduction::apply_filter(btrgb::Image* img1, btrgb::Image* img2) {
-    cv::Mat im1 = img1->getMat();
-    cv::Mat im2 = img2->getMat();
+    this->apply_filter(img1);
+    this->apply_filter(img2);
+}
+
+void NoiseReduction::apply_filter(btrgb::Image* img) {
+    cv::Mat im = img->getMat();
 
     int ksize = 0;
     //Sharpen value passed in 
@@ -60,8 +93,7 @@ void NoiseReduction::apply_filter(btrgb::Image* img1, btrgb::Image* img2) {
         ksize = 5;
     }
 
-    cv::Mat Hblurred1;
-    cv::Mat Hblurred2;
+    cv::Mat Hblurred;
 
     //High Frequency Kernel larger sigma = more sharp
     //Low = 0.5  Med = 1  High = 1.5
@@ -72,27 +104,22 @@ void NoiseReduction::apply_filter(btrgb::Image* img1, btrgb::Image* img2) {
     int HsharpFactor = 1;
 
     //High Freq Blur
-    GaussianBlur(im1, Hblurred1, Size(ksize, ksize), 1, 1);
-    GaussianBlur(im2, Hblurred2, Size(ksize, ksize), 1, 1);
+    GaussianBlur(im, Hblurred, Size(ksize, ksize), 1, 1);
 
     //Create high freq mask
-    cv::Mat unsharpMask1 = im1 - Hblurred1;
-    cv::Mat unsharpMask2 = im2 - Hblurred2;
+    cv::Mat unsharpMask = im - Hblurred;
 
     //Apply high freq mask
-    im1 = im1 + HsharpFactor * unsharpMask1;
-    im2 = im2 + HsharpFactor * unsharpMask2;
+    im = im + HsharpFactor * unsharpMask;
 
     //Noise reduction
     //Using Bilateral Filtering for highest accuracy
     //Filter can't run in place must copy to temp matrixs
-    cv::Mat filter1;
-    cv::Mat filter2;
+    cv::Mat filter;
     int noiseReducKernel = 2;
-    cv::bilateralFilter(im1, filter1, noiseReducKernel, noiseReducKernel * 2, noiseReducKernel / 2);
-    cv::bilateralFilter(im2, filter2, noiseReducKernel, noiseReducKernel * 2, noiseReducKernel / 2);
+    cv::bilateralFilter(im, filter, noiseReducKernel, noiseReducKernel * 2, noiseReducKernel / 2);
 
     //Copy back to art object
-    filter1.copyTo(im1);
-    filter2.copyTo(im2);
-}
\ No newline at end of file
+    filter.copyTo(im);
+    img->pixelsChanged();
+}
@@ -31,9 +31,14 @@ void PixelRegestor::execute(CommunicationObj *comms, btrgb::ArtObject *images)
         regestration_count = 2;
     }
 
-    this->appy_regestration(comms, img1, img2, 1, regestration_count);
+    {
+        btrgb::TraceSpan span(images->get_trace(), "Register Art");
+        this->appy_regestration(comms, img1, img2, 1, regestration_count);
+    }
 
     if(found_target){
+        images->check_cancelled();
+        btrgb::TraceSpan span(images->get_trace(), "Register Target");
         this->appy_regestration(comms, target1, target2, 2, regestration_count);
     }
 
@@ -167,6 +172,7 @@ void PixelRegestor::appy_regestration(CommunicationObj* comms, btrgb::Image *img
 
     // Copy image
     im2reg.copyTo(im2);
+    img2->pixelsChanged();
 
     // Print estimated homography, prolly want to store this somewhere for report?
     cout << "Estimated homography : \n" << h;
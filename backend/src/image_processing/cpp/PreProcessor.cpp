@@ -9,12 +9,11 @@ void PreProcessor::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
     comms->send_info("Starting PreProcessing", this->get_name());
     double count = 0;
     double total = this->components.size();
-    for(const auto& component : this->components){
-      double currProgress = count / total;
-      comms->send_progress(currProgress, this->get_name());
-      component->execute(comms, images);
-      comms->send_binary(images->getImage("art1"), btrgb::FAST);
+    comms->send_progress(0, this->get_name());
+    this->execute_components(comms, images, [&](const std::shared_ptr<ImgProcessingComponent>& component){
       count++;
-    }
+      comms->send_progress(count / total, this->get_name());
+      comms->send_binary(images->getImage("art1"), btrgb::FAST);
+    });
     comms->send_info("PreProcessing Done!!!", this->get_name());
 }
@@ -0,0 +1,42 @@
+#include "../header/PreviewCalibrator.h"
+
+PreviewCalibrator::PreviewCalibrator(const std::vector<std::shared_ptr<ImgProcessingComponent>>& components)
+    : CompositComponent("Preview Calibration") {
+        this->init_components(components);
+}
+
+void PreviewCalibrator::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
+    comms->send_info("Starting Preview Calibration", this->get_name());
+
+    // Crop every set down to the target region
+    std::unique_ptr<btrgb::ArtObject> preview;
+    try {
+        preview = images->target_preview(PREVIEW_MARGIN);
+    }
+    catch (const std::exception& e) {
+        throw ImgProcessingComponent::error(e.what(), this->get_name());
+    }
+
+    double count = 0;
+    double total = this->components.size();
+    comms->send_progress(0, this->get_name());
+    this->execute_components(comms, preview.get(), [&](const std::shared_ptr<ImgProcessingComponent>& component){
+        count++;
+        comms->send_progress(count / total, this->get_name());
+    });
+
+    // Report preview results
+    CalibrationResults* calibration = preview->get_results_obj(btrgb::ResultType::CALIBRATION);
+    double deltaE = calibration->get_double(CM_DELTA_E_AVG);
+    double rmse = calibration->get_double(SP_RMSE);
+    comms->send_calibration_preview(deltaE, rmse);
+    comms->send_binary(preview->getImage(CM_IMAGE_KEY), btrgb::FAST);
+
+    // Keep them around for the full run
+    CalibrationResults* general = images->get_results_obj(btrgb::ResultType::GENERAL);
+    general->store_double(GI_PREVIEW_DELTA_E, deltaE);
+    general->store_double(GI_PREVIEW_RMSE, rmse);
+
+    comms->send_progress(1, this->get_name());
+    comms->send_info("Preview Calibration Done!!!", this->get_name());
+}
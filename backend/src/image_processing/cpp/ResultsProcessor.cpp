@@ -1,4 +1,5 @@
 #include "image_processing/header/ResultsProcessor.h"
+#include "utils/thread_pool.hpp"
 
 ResultsProcessor::~ResultsProcessor(){
     if(nullptr != this->formater){
@@ -26,14 +27,28 @@ void ResultsProcessor::execute(CommunicationObj* comms, btrgb::ArtObject* images
     this->colorimetry_ver_f_name = this->build_output_name("ColorimetryVerification", "csv");
     this->R_camera_ver_f_name = this->build_output_name("R_cameraVerification", "csv");
     
-    // Output Results
-    this->output_btrgb_results(images);
-    this->output_user_results(images);  
-
-    comms->send_progress(0.2,this->get_name());
-
-    // Output Images 
+    // Time spent in each component so far, the full trace is written once the pipeline is done
+    btrgb::Trace* trace = images->get_trace();
+    std::string stage_times = (nullptr != trace) ? trace->summary("component") : "";
+    CalibrationResults* general_info = images->get_results_obj(btrgb::ResultType::GENERAL);
+    general_info->store_string(GI_STAGE_TIMES, stage_times);
+
+    // Memory used by this request so far
+    btrgb::MemoryAccount* memory = btrgb::MemoryAccount::current();
+    const double MB = 1024.0 * 1024.0;
+    general_info->store_double(GI_PEAK_MEMORY, (nullptr != memory) ? memory->peak_bytes() / MB : 0);
+    general_info->store_string(GI_STAGE_MEMORY, (nullptr != memory) ? memory->stage_summary() : "");
+    general_info->store_double(GI_PEAK_RSS, btrgb::MemoryTracker::peak_rss_bytes() / MB);
+
+    // Output Results and Images
+    // The result files and the images don't depend on each other so they are written at the same time
+    btrgb::ThreadPool::TaskGroup group;
+    group.run([&](){
+        this->output_btrgb_results(images);
+        this->output_user_results(images);
+    });
     this->output_images(images);
+    group.wait();
 
     
     // Store PRO_file so we can access it from Pipeline
@@ -43,12 +58,15 @@ void ResultsProcessor::execute(CommunicationObj* comms, btrgb::ArtObject* images
 }
 
 void ResultsProcessor::output_images(btrgb::ArtObject* images){
-    try{
-    // Write CM Calibrated Image
-    images->outputImageAs(btrgb::TIFF, CM_IMAGE_KEY, this->CM_f_name);
-    }catch(std::exception e){
-        std::cerr << "Failed to write CM_Image: " << e.what() << std::endl; 
-    }
+    btrgb::ThreadPool::TaskGroup group;
+    group.run([&](){
+        try{
+        // Write CM Calibrated Image
+        images->outputImageAs(btrgb::TIFF, CM_IMAGE_KEY, this->CM_f_name);
+        }catch(std::exception e){
+            std::cerr << "Failed to write CM_Image: " << e.what() << std::endl; 
+        }
+    });
 
     // Write Spectral Image
     try{
@@ -60,6 +78,7 @@ void ResultsProcessor::output_images(btrgb::ArtObject* images){
     }catch(std::exception e){
         std::cerr << "Failed to write SP_Image: " << e.what() << std::endl; 
     }
+    group.wait();
 }
 
 void ResultsProcessor::output_btrgb_results(btrgb::ArtObject* images){
@@ -77,6 +96,8 @@ void ResultsProcessor::output_btrgb_results(btrgb::ArtObject* images){
     output_files.insert_or_assign("R_camera", this->R_camera_f_name);
     output_files.insert_or_assign("ColorimetryVerification", this->colorimetry_ver_f_name);
     output_files.insert_or_assign("R_cameraVerification", this->R_camera_ver_f_name);
+    if(nullptr != images->get_trace())
+        output_files.insert_or_assign("Trace", TRACE_FILE);
     // Add all json objects to the main json body to be writen to .btrgb file
     jsoncons::json btrgb_json;
     btrgb_json.insert_or_assign("OutPutFiles", output_files);
@@ -0,0 +1,81 @@
+#include "../header/SetStreamer.h"
+#include "utils/bounded_queue.hpp"
+#include "utils/thread_budget.hpp"
+
+SetStreamer::SetStreamer(std::shared_ptr<ImageReader> reader, std::shared_ptr<BitDepthScaler> scaler,
+    std::shared_ptr<FlatFieldor> flat_fieldor, std::shared_ptr<NoiseReduction> noise_reduction)
+    : CompositComponent("Set Streamer") {
+        this->reader = reader;
+        this->scaler = scaler;
+        this->flat_fieldor = flat_fieldor;
+        this->noise_reduction = noise_reduction;
+        this->init_components({reader, scaler, flat_fieldor});
+        if(nullptr != noise_reduction)
+            this->init_components({noise_reduction});
+}
+
+void SetStreamer::execute(CommunicationObj* comms, btrgb::ArtObject* images) {
+    comms->send_info("Reading and correcting each image set", this->get_name());
+    comms->send_progress(0, this->get_name());
+
+    int set_count = 0;
+    while(images->imageExists("art" + std::to_string(set_count + 1)))
+        set_count++;
+
+    // Read each set on a seperate thread, handing them over once they are ready to be flat fielded
+    btrgb::BoundedQueue<int> read_sets(SET_QUEUE_SIZE);
+    std::exception_ptr read_error;
+    btrgb::MemoryAccount* account = btrgb::MemoryAccount::current();
+    std::thread read_thread([&]() {
+        btrgb::MemoryAccount::Bind bind(account);
+        btrgb::ThreadBudget::get_instance()->limit_thread();
+        try {
+            for(int set = 1; set <= set_count; set++) {
+                this->run_stage(this->reader, images, [&]() { this->reader->read_set(comms, images, set); });
+                this->run_stage(this->scaler, images, [&]() { this->scaler->scale_set(comms, images, set); });
+                // Closed when correcting failed, nothing more to read
+                if(!read_sets.push(set))
+                    break;
+            }
+        }
+        catch(...) {
+            read_error = std::current_exception();
+        }
+        read_sets.close();
+    });
+
+    // Correct each set as soon as it has been read
+    std::exception_ptr correct_error;
+    try {
+        double count = 0;
+        int set;
+        while(read_sets.pop(set)) {
+            this->run_stage(this->flat_fieldor, images, [&]() { this->flat_fieldor->flat_field_set(comms, images, set); });
+            if(nullptr != this->noise_reduction)
+                this->run_stage(this->noise_reduction, images, [&]() { this->noise_reduction->filter_set(comms, images, set); });
+            count++;
+            comms->send_progress(count / set_count, this->get_name());
+        }
+    }
+    catch(...) {
+        correct_error = std::current_exception();
+        read_sets.close();
+    }
+    read_thread.join();
+
+    if(nullptr != read_error)
+        std::rethrow_exception(read_error);
+    if(nullptr != correct_error)
+        std::rethrow_exception(correct_error);
+
+    comms->send_info("Every image set has been read and corrected", this->get_name());
+}
+
+void SetStreamer::run_stage(const std::shared_ptr<ImgProcessingComponent>& component, btrgb::ArtObject* images, std::function<void()> stage) {
+    images->check_cancelled();
+    btrgb::TraceSpan span(images->get_trace(), component->get_name(), "component");
+    btrgb::MemoryStage memory(component->get_name());
+    stage();
+    span.set_arg("peakMatBytes", memory.peak_bytes());
+    span.set_arg("rssBytes", btrgb::MemoryTracker::rss_bytes());
+}
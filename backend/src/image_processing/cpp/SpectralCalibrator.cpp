@@ -77,14 +77,22 @@ void SpectralCalibrator::execute(CommunicationObj *comms, btrgb::ArtObject* imag
     TimeTracker time_tracker;
     time_tracker.start_timeing();
     // Optimize M_refl to minimized Z
-    double res = min_solver->minimize(this->input_array);
+    double res;
+    {
+        btrgb::TraceSpan span(images->get_trace(), "SP Optimization");
+        res = min_solver->minimize(this->input_array);
+    }
     time_tracker.end_timeing();
+    images->check_cancelled();
 
     comms->send_progress(0.9, this->get_name());
 
     this->store_results(images);  
 
-    this->store_spectral_img(images); 
+    {
+        btrgb::TraceSpan span(images->get_trace(), "SP Apply");
+        this->store_spectral_img(images); 
+    }
 
     std::cout << "SpectralCalibration done" << std::endl;
     comms->send_progress(1, this->get_name());
@@ -134,8 +142,8 @@ void SpectralCalibrator::store_spectral_img(btrgb::ArtObject *images){
     btrgb::Image* art1 = images->getImage("art1");
     btrgb::Image* art2 = images->getImage("art2");
     btrgb::Image* art[2] = {art1, art2};
-    int height = images->get_results_obj(btrgb::ResultType::GENERAL)->get_int(GI_IMG_ROWS);
-    int width = images->get_results_obj(btrgb::ResultType::GENERAL)->get_int(GI_IMG_COLS);
+    // Not GI_IMG_ROWS, color managment may still be running
+    int height = art1->height();
     cv::Mat camra_sigs = btrgb::calibration::build_camra_signals_matrix(art, 2, 6);
     btrgb::Image *spectral_img = btrgb::calibration::camera_sigs_2_image(camra_sigs, height);
 
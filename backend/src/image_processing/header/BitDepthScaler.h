@@ -9,6 +9,14 @@ class BitDepthScaler : public LeafComponent {
         BitDepthScaler();
         ~BitDepthScaler();
         void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+
+        /**
+         * @brief Scale only the images of one capture set (art, white, dark and target of that number)
+         */
+        void scale_set(CommunicationObj* comms, btrgb::ArtObject* images, int set);
+
+    private:
+        void _scale(CommunicationObj* comms, btrgb::Image* im);
 };
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef BEYOND_RGB_BACKEND_CHECKPOINTREADER_H
+#define BEYOND_RGB_BACKEND_CHECKPOINTREADER_H
+
+#include "image_processing/header/CompositComponent.h"
+#include "ImageUtil/CheckpointCache.hpp"
+
+/**
+ * @brief Takes the place of the stages a checkpoint covers: loads the images and results
+ * the stages produced last time instead of running them.
+ *
+ * The components are the stages being skipped. They are only run if the checkpoint turns out
+ * to be unreadable, so the run still completes, just without the time savings.
+ */
+class CheckpointReader : public CompositComponent {
+
+public:
+    CheckpointReader(const std::vector<std::shared_ptr<ImgProcessingComponent>>& components, uint64_t key);
+    void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+
+    /**
+     * @brief Listed as a single step, the skipped stages normally don't run
+     */
+    jsoncons::json get_component_list() override;
+
+private:
+    uint64_t key;
+
+};
+
+#endif //BEYOND_RGB_BACKEND_CHECKPOINTREADER_H
@@ -0,0 +1,27 @@
+#ifndef BEYOND_RGB_BACKEND_CHECKPOINTWRITER_H
+#define BEYOND_RGB_BACKEND_CHECKPOINTWRITER_H
+
+#include "image_processing/header/ImgProcessingComponent.h"
+#include "ImageUtil/CheckpointCache.hpp"
+
+/**
+ * @brief Runs a component, then saves the images to the checkpoint cache so a later run
+ * with the same inputs and settings can resume from there (see CheckpointReader).
+ * Shows up as, and reports as, the component it wraps.
+ *
+ * A failure to save is reported but never fails the run.
+ */
+class CheckpointWriter : public ImgProcessingComponent {
+
+public:
+    CheckpointWriter(std::shared_ptr<ImgProcessingComponent> component, uint64_t key);
+    void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+    jsoncons::json get_component_list() override;
+
+private:
+    std::shared_ptr<ImgProcessingComponent> component;
+    uint64_t key;
+
+};
+
+#endif //BEYOND_RGB_BACKEND_CHECKPOINTWRITER_H
@@ -8,6 +8,7 @@
 
 #include "ImageUtil/ColorTarget.hpp"
 #include "ImageUtil/ColorProfiles.hpp"
+#include "server/globals_siglton.hpp"
 #include "utils/csv_parser.hpp"
 #include "image_processing/header/LeafComponent.h"
 #include "reference_data/ref_data_defines.hpp"
@@ -87,6 +88,16 @@ private:
      */
     void update_image(btrgb::ArtObject* images);
 
+    /**
+     * @brief Applies M and offsets to art1 and art2 using a double precision 6xN matrix
+     * Only used when float calibration has been turned off (--calibration_precision=double)
+     *
+     * @param art art1 and art2
+     * @param height the height of the art images
+     * @return cv::Mat the resulting three-channel CV_32F image in XYZ
+     */
+    cv::Mat apply_double(btrgb::Image* art[], int height);
+
     /**
      * @brief Saves optimized M and offset as well the final deltaE values
      *
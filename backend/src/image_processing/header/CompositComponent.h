@@ -2,7 +2,12 @@
 #define COMPOSIT_COMPONENT_H
 
 #include "image_processing/header/ImgProcessingComponent.h"
+#include "utils/memory_tracker.hpp"
+#include "utils/metrics.hpp"
+#include "utils/thread_pool.hpp"
 #include <jsoncons/json_reader.hpp>
+#include <algorithm>
+#include <map>
 
 class CompositComponent : public ImgProcessingComponent{
     public:
@@ -24,8 +29,161 @@ class CompositComponent : public ImgProcessingComponent{
             }
         }
 
+        /**
+         * @brief Let a component start as soon as the given components are done,
+         * instead of after every component before it
+         * Components that don't depend on each other then run at the same time (see execute_components).
+         */
+        void set_dependencies(const std::shared_ptr<ImgProcessingComponent>& component, const std::vector<std::shared_ptr<ImgProcessingComponent>>& dependencies){
+            std::vector<size_t>& indices = this->dependencies[this->index_of(component)];
+            indices.clear();
+            for(auto & dependency : dependencies){
+                indices.push_back(this->index_of(dependency));
+            }
+        }
+
     protected:
         std::vector<std::shared_ptr<ImgProcessingComponent>> components;
+        // Indices of the components each component waits for, components without an entry wait for every component before them
+        std::map<size_t, std::vector<size_t>> dependencies;
+
+        size_t index_of(const std::shared_ptr<ImgProcessingComponent>& component){
+            auto found = std::find(this->components.begin(), this->components.end(), component);
+            if(found == this->components.end())
+                throw std::logic_error("[CompositComponent] " + component->get_name() + " is not a component of " + this->get_name());
+            return found - this->components.begin();
+        }
+
+        /**
+         * @brief Run every component, each one as soon as the components it depends on are done.
+         * Components that are ready at the same time run concurrently on the ThreadPool, one of them on the calling thread.
+         * With no dependencies set this runs the components in order on the calling thread.
+         *
+         * Once a component fails nothing new is started, the first error is rethrown once the running ones are done.
+         * @param on_done called on the calling thread after each component finishes, in the order they finish
+         */
+        void execute_components(CommunicationObj* comms, btrgb::ArtObject* images,
+            std::function<void(const std::shared_ptr<ImgProcessingComponent>&)> on_done = nullptr){
+
+            size_t count = this->components.size();
+            std::vector<int> waiting_on(count, 0);
+            std::vector<std::vector<size_t>> dependents(count);
+            std::vector<size_t> ready;
+            for(size_t i = 0; i < count; i++){
+                std::vector<size_t> before;
+                if(this->dependencies.contains(i))
+                    before = this->dependencies[i];
+                else
+                    for(size_t j = 0; j < i; j++) before.push_back(j);
+                waiting_on[i] = before.size();
+                for(size_t j : before) dependents[j].push_back(i);
+                if(before.empty()) ready.push_back(i);
+            }
+
+            std::mutex mutex;
+            std::condition_variable finished_cv;
+            std::vector<size_t> finished;
+            std::exception_ptr error;
+            auto run = [&](size_t i){
+                std::exception_ptr component_error;
+                try {
+                    this->execute_component(this->components[i], comms, images);
+                }
+                catch(...) {
+                    component_error = std::current_exception();
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                if(component_error && !error) error = component_error;
+                finished.push_back(i);
+                finished_cv.notify_all();
+            };
+
+            btrgb::ThreadPool* pool = btrgb::ThreadPool::get_instance();
+            size_t done = 0;
+            int running = 0;
+            while(done < count){
+                // Start everything that is ready, the last one on this thread
+                bool failed;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    failed = (nullptr != error);
+                }
+                while(!failed && !ready.empty()){
+                    size_t i = ready.back();
+                    ready.pop_back();
+                    running++;
+                    if(ready.empty())
+                        run(i);
+                    else
+                        pool->submit([&run, i](){ run(i); });
+                }
+
+                if(running == 0 && failed)
+                    break;
+                if(running == 0)
+                    throw std::logic_error("[CompositComponent] " + this->get_name() + " has components that depend on each other");
+
+                // Wait for at least one to finish, helping with queued work meanwhile
+                std::vector<size_t> newly_finished;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    while(finished.empty()){
+                        lock.unlock();
+                        bool ran = pool->run_one();
+                        lock.lock();
+                        if(!ran && finished.empty())
+                            finished_cv.wait_for(lock, std::chrono::milliseconds(1));
+                    }
+                    newly_finished.swap(finished);
+                    failed = (nullptr != error);
+                }
+
+                for(size_t i : newly_finished){
+                    running--;
+                    done++;
+                    if(failed)
+                        continue;
+                    try {
+                        if(on_done) on_done(this->components[i]);
+                    }
+                    catch(...) {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        if(!error) error = std::current_exception();
+                        failed = true;
+                        continue;
+                    }
+                    for(size_t dependent : dependents[i]){
+                        if(--waiting_on[dependent] == 0)
+                            ready.push_back(dependent);
+                    }
+                }
+                if(failed && running == 0)
+                    break;
+            }
+            if(error)
+                std::rethrow_exception(error);
+        }
+
+        /**
+         * @brief Run one of the components, stopping first if the process was cancelled.
+         * The component's run is recorded to the trace along with the size of the images it processed
+         * and the memory used by the request while it ran, and counts toward the component's throughput.
+         */
+        void execute_component(const std::shared_ptr<ImgProcessingComponent>& component, CommunicationObj* comms, btrgb::ArtObject* images){
+            images->check_cancelled();
+            btrgb::TraceSpan span(images->get_trace(), component->get_name(), "component");
+            btrgb::MemoryStage memory(component->get_name());
+            int64_t pixels_before = images->pixelCount();
+            int64_t start_ns = btrgb::Trace::now_ns();
+            component->execute(comms, images);
+            // Whichever is bigger covers components that read in images as well as ones that drop them
+            int64_t pixels = std::max(pixels_before, images->pixelCount());
+            btrgb::Metrics::throughput(component->get_name()).record(pixels, btrgb::Trace::now_ns() - start_ns);
+            span.set_pixels(pixels);
+            span.set_bytes(images->byteCount());
+            span.set_arg("peakMatBytes", memory.peak_bytes());
+            span.set_arg("rssBytes", btrgb::MemoryTracker::rss_bytes());
+        }
 };
 
 #endif // COMPOSIT_COMPONENT_H
\ No newline at end of file
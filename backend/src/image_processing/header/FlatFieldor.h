@@ -9,11 +9,14 @@ class FlatFieldor : public LeafComponent{
 private:
     float w;
     void wCalc(float pAvg, float wAvg, double yRef);
-    void pixelOperation(int h, int wid, int c, btrgb::Image* a, btrgb::Image* wh, btrgb::Image* d, btrgb::Image* ac);
+    void pixelOperation(int h, int wid, int c, btrgb::Image* a, btrgb::Image* wh, btrgb::Image* d, btrgb::Image* ac, btrgb::ArtObject* images);
+    void calculateW(btrgb::ArtObject* images);
+    void flatFieldImages(btrgb::ArtObject* images, int set);
 
 public:
     FlatFieldor() : LeafComponent("Flat Fielding"){}
     void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+    void flat_field_set(CommunicationObj* comms, btrgb::ArtObject* images, int set);
     void store_results(btrgb::ArtObject* images);
 };
 
@@ -8,14 +8,29 @@ class ImageReader: public LeafComponent {
 
     public:
         enum reader_strategy {none, RAW_LibRaw, TIFF_OpenCV, TIFF_LibTiff};
-        ImageReader();
+        /**
+         * @param draft read images at half resolution (draft processing mode)
+         * @param scratch_frames keep the white and dark frames in memory-mapped scratch files,
+         *  they are only needed for flat fielding
+         */
+        ImageReader(bool draft = false, bool scratch_frames = false);
         ~ImageReader();
         void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
 
+        /**
+         * @brief Read only the images of one capture set (art, white, dark and target of that number)
+         * Set 1 has to be read first, the bit depth of every image is found from white1.
+         */
+        void read_set(CommunicationObj* comms, btrgb::ArtObject* images, int set);
+
     private:
         reader_strategy _current_strategy = reader_strategy::none;
         btrgb::ImageReaderStrategy* _reader = nullptr;
+        bool _draft = false;
+        bool _scratch_frames = false;
+        std::shared_ptr<int> _bit_depth;
         void _set_strategy(reader_strategy strategy);
+        void _read(std::string key, btrgb::Image* im, btrgb::ArtObject* images);
         void _average_greens(cv::Mat& input, cv::Mat& output);
 
 
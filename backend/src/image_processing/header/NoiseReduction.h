@@ -12,7 +12,12 @@ public:
     ~NoiseReduction() {};
     NoiseReduction(std::string SharpenFactor) : LeafComponent("Noise Reduction"), SharpenFactor(SharpenFactor) {};
     void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+    /**
+     * @brief Filter only the art and target image of one capture set
+     */
+    void filter_set(CommunicationObj* comms, btrgb::ArtObject* images, int set);
     void apply_filter(btrgb::Image *img1, btrgb::Image *img2);
+    void apply_filter(btrgb::Image *img);
 };
 
 
@@ -0,0 +1,26 @@
+#ifndef BEYOND_RGB_BACKEND_PREVIEWCALIBRATOR_H
+#define BEYOND_RGB_BACKEND_PREVIEWCALIBRATOR_H
+
+#include "image_processing/header/CompositComponent.h"
+#include "image_processing/results/calibration_results.hpp"
+
+// Margin added around the target, as a fraction of the target size
+#define PREVIEW_MARGIN 0.1
+
+/**
+ * @brief Runs its components on a copy of the ArtObject that only contains the color target region of each image.
+ * This gives the user calibration results (deltaE/RMSE) within seconds, before the full images are processed.
+ * The ArtObject given to execute is not modified other than storing the preview results in its GeneralInfo.
+ * 
+ * Should be placed after the ImageReader and BitDepthScaler.
+ * The components are expected to be FlatFieldor, PixelRegestor, ColorManagedCalibrator and SpectralCalibrator.
+ */
+class PreviewCalibrator : public CompositComponent {
+
+public:
+    PreviewCalibrator(const std::vector<std::shared_ptr<ImgProcessingComponent>>& components);
+    void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+
+};
+
+#endif //BEYOND_RGB_BACKEND_PREVIEWCALIBRATOR_H
@@ -10,6 +10,7 @@
 #include "image_processing/results/colorimetry_formater.hpp"
 #include "image_processing/results/r_camera_fromater.hpp"
 #include "utils/general_utils.hpp"
+#include "utils/memory_tracker.hpp"
 
 #define IMG_FILE_NAME(x, id) ("BTRGB_" x "_" id)
 
@@ -0,0 +1,46 @@
+#ifndef BEYOND_RGB_BACKEND_SETSTREAMER_H
+#define BEYOND_RGB_BACKEND_SETSTREAMER_H
+
+#include "image_processing/header/CompositComponent.h"
+#include "image_processing/header/ImageReader.h"
+#include "image_processing/header/BitDepthScaler.h"
+#include "image_processing/header/FlatFieldor.h"
+#include "image_processing/header/NoiseReduction.h"
+
+// Number of read sets allowed to wait for correction before reading stops
+#define SET_QUEUE_SIZE 1
+
+/**
+ * @brief Takes the place of the ImageReader, BitDepthScaler, FlatFieldor and NoiseReduction in the PreProcessor
+ * and runs them one capture set at a time: while a set is being flat fielded and filtered the next one is read.
+ *
+ * Reading runs on its own thread and hands each set over through a BoundedQueue, so reading never gets more than
+ * SET_QUEUE_SIZE sets ahead. The white and dark images of a set are removed as soon as the set is flat fielded.
+ *
+ * The images of every set must be in the ArtObject, unread, and there can't be a preview between reading and
+ * flat fielding since the white and dark images of set 1 are gone by the time the last set is read.
+ */
+class SetStreamer : public CompositComponent {
+
+public:
+    /**
+     * @param noise_reduction nullptr if no sharpening is done
+     */
+    SetStreamer(std::shared_ptr<ImageReader> reader, std::shared_ptr<BitDepthScaler> scaler,
+        std::shared_ptr<FlatFieldor> flat_fieldor, std::shared_ptr<NoiseReduction> noise_reduction = nullptr);
+    void execute(CommunicationObj* comms, btrgb::ArtObject* images) override;
+
+private:
+    std::shared_ptr<ImageReader> reader;
+    std::shared_ptr<BitDepthScaler> scaler;
+    std::shared_ptr<FlatFieldor> flat_fieldor;
+    std::shared_ptr<NoiseReduction> noise_reduction;
+
+    /**
+     * @brief Run one component on one set, timed and memory tracked under the component's name
+     */
+    void run_stage(const std::shared_ptr<ImgProcessingComponent>& component, btrgb::ArtObject* images, std::function<void()> stage);
+
+};
+
+#endif //BEYOND_RGB_BACKEND_SETSTREAMER_H
@@ -13,6 +13,7 @@ CalibrationResults::~CalibrationResults(){
 
 
 bool CalibrationResults::contains_results(){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     bool has_matix = this->result_matricies.size() > 0;
     bool has_int = this->result_ints.size() > 0;
     bool has_double = this->result_doubles.size() > 0;
@@ -20,22 +21,27 @@ bool CalibrationResults::contains_results(){
 }
 
 void CalibrationResults::store_matrix(std::string key, cv::Mat result){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     this->result_matricies[key] = result;
 }
 
 void CalibrationResults::store_int(std::string key, int value){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     this->result_ints[key] = value;
 }
 
 void CalibrationResults::store_double(std::string key, double value){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     this->result_doubles[key] = value;
 }
 
 void CalibrationResults::store_string(std::string key, std::string value){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     this->results_strings[key] = value;
 }
 
 cv::Mat CalibrationResults::get_matrix(std::string key){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     if(this->result_matricies.contains(key)){
         cv::Mat result;
         this->result_matricies[key].copyTo(result);
@@ -45,6 +51,7 @@ cv::Mat CalibrationResults::get_matrix(std::string key){
 }
 
 int CalibrationResults::get_int(std::string key){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     if(this->result_ints.contains(key)){
         return this->result_ints[key];
     }
@@ -52,6 +59,7 @@ int CalibrationResults::get_int(std::string key){
 }
 
 double CalibrationResults::get_double(std::string key){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     if(this->result_doubles.contains(key)){
         return this->result_doubles[key];
     }
@@ -59,6 +67,7 @@ double CalibrationResults::get_double(std::string key){
 }
 
 std::string CalibrationResults::get_string(std::string key){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     if(this->results_strings.contains(key)){
         return this->results_strings[key];
     }
@@ -66,6 +75,7 @@ std::string CalibrationResults::get_string(std::string key){
 }
 
 void CalibrationResults::write_results(std::ostream &output_stream){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     if(this->contains_results()){
         this->write_matrices(output_stream);
         this->write_ints(output_stream);
@@ -163,6 +173,7 @@ void CalibrationResults::write_matrix_value(std::ostream &output_stream, cv::Mat
 }
 
 jsoncons::json CalibrationResults::jsonafy(){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     jsoncons::json body;
     // Jsonafy the result matracies
     jsoncons::json matracies = this->make_json_from_map<cv::Mat>(this->result_matricies);
@@ -181,6 +192,7 @@ jsoncons::json CalibrationResults::jsonafy(){
 }
 
 void CalibrationResults::de_jsonafy(jsoncons::json json){
+    std::unique_lock<std::recursive_mutex> lock(this->results_mutex);
     try{
         Json parser(json);
         this->reconstruct_matracies(parser);
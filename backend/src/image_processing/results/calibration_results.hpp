@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <unordered_map>
 
 #include "utils/csv_parser.hpp"
@@ -49,6 +50,16 @@
 #define GI_Y                  "Y white patche meas"
 #define GI_W                  "W Value"
 #define GI_ADVANCED_FILTERS   "Sharpaning/NoiseReduction Filter Settings"
+#define GI_DRAFT              "Draft (Half Resolution)"
+#define GI_PATCH_STATISTIC    "Color Patch Statistic"
+#define GI_PREVIEW_DELTA_E    "Preview CM DeltaE Mean"
+#define GI_PREVIEW_RMSE       "Preview SP RMSE"
+#define GI_CM_PRECISION       "CM Apply Precision"
+#define GI_CM_MAX_DEVIATION   "CM Apply Max Deviation (16 bit)"
+#define GI_STAGE_TIMES        "Stage Times"
+#define GI_PEAK_MEMORY        "Peak Image Memory (MB)"
+#define GI_STAGE_MEMORY       "Stage Peak Image Memory"
+#define GI_PEAK_RSS           "Peak Process Memory (MB)"
 
 // Verification Keys
 #define V_XYZ              "Verification Calibrated XYZ Values"
@@ -262,6 +273,8 @@ private:
     std::unordered_map<std::string, double> result_doubles;
     std::unordered_map<std::string, std::string> results_strings;
     int cur_mat_type;
+    // Components running side by side store their results at the same time
+    std::recursive_mutex results_mutex;
   
     /**
      * @brief Itterates over every matix stored and appends its output to the given output_stream
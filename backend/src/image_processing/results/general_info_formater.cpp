@@ -41,6 +41,26 @@ void GeneralInfoFormater::write_format(std::ostream &output_stream, CalibrationR
         this->get_result<double>(GI_W, results) << std::endl;
     output_stream << GI_ADVANCED_FILTERS << GI_DELIM <<
         this->get_result<std::string>(GI_ADVANCED_FILTERS, results) << std::endl;
+    output_stream << GI_DRAFT << GI_DELIM <<
+        this->get_result<std::string>(GI_DRAFT, results) << std::endl;
+    output_stream << GI_PATCH_STATISTIC << GI_DELIM <<
+        this->get_result<std::string>(GI_PATCH_STATISTIC, results) << std::endl;
+    output_stream << GI_CM_PRECISION << GI_DELIM <<
+        this->get_result<std::string>(GI_CM_PRECISION, results) << std::endl;
+    output_stream << GI_CM_MAX_DEVIATION << GI_DELIM <<
+        this->get_result<double>(GI_CM_MAX_DEVIATION, results) << std::endl;
+    output_stream << GI_PREVIEW_DELTA_E << GI_DELIM <<
+        this->get_result<double>(GI_PREVIEW_DELTA_E, results) << std::endl;
+    output_stream << GI_PREVIEW_RMSE << GI_DELIM <<
+        this->get_result<double>(GI_PREVIEW_RMSE, results) << std::endl;
+    output_stream << GI_STAGE_TIMES << GI_DELIM <<
+        this->get_result<std::string>(GI_STAGE_TIMES, results) << std::endl;
+    output_stream << GI_PEAK_MEMORY << GI_DELIM <<
+        this->get_result<double>(GI_PEAK_MEMORY, results) << std::endl;
+    output_stream << GI_STAGE_MEMORY << GI_DELIM <<
+        this->get_result<std::string>(GI_STAGE_MEMORY, results) << std::endl;
+    output_stream << GI_PEAK_RSS << GI_DELIM <<
+        this->get_result<double>(GI_PEAK_RSS, results) << std::endl;
     
     #undef GI_DELIM
 }
\ No newline at end of file
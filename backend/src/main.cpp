@@ -1,8 +1,18 @@
 
+#include <filesystem>
 #include <iostream>
 #include "server/request_server.hpp"
 #include "utils/cmd_arg_manager.hpp"
 #include "server/globals_siglton.hpp"
+#include "utils/memory_tracker.hpp"
+#include "utils/buffer_pool.hpp"
+#include "utils/scratch_allocator.hpp"
+#include "ImageUtil/CheckpointCache.hpp"
+#include "utils/thread_budget.hpp"
+#include "ImageUtil/DecodePrefetcher.hpp"
+#include "ImageUtil/DecodedImageCache.hpp"
+#include "ImageUtil/ThumbnailCache.hpp"
+#include "ImageUtil/TilePyramid.hpp"
 
 
 //Testing Includes: Remove before submiting PR
@@ -13,6 +23,47 @@ void testFunc() {
 
 int main(int argc, char** argv) {
   CMDArgManager::process_args(argc, argv);
+
+  // Pool large image buffers and count every cv::Mat allocation from here on
+  GlobalsSinglton* globals = GlobalsSinglton::get_instance();
+  if (globals->pool_retention_mb() > 0) {
+    btrgb::BufferPool::get_instance()->set_retention_cap(size_t(globals->pool_retention_mb()) * 1024 * 1024);
+    btrgb::BufferPool::get_instance()->set_huge_pages(globals->huge_pages());
+    static btrgb::PooledMatAllocator* pooled_allocator = new btrgb::PooledMatAllocator;
+    btrgb::MemoryTracker::install(pooled_allocator);
+  }
+  else {
+    btrgb::MemoryTracker::install();
+  }
+
+  // Large images go to memory-mapped scratch files once the budget is used up
+  if (!globals->scratch_dir().empty())
+    btrgb::ScratchAllocator::get_instance()->set_directory(globals->scratch_dir());
+  btrgb::ScratchAllocator::get_instance()->set_memory_budget(size_t(globals->memory_budget_mb()) * 1024 * 1024);
+
+  // Checkpoints of the pre-processing stages for re-runs to resume from
+  btrgb::CheckpointCache* checkpoints = btrgb::CheckpointCache::get_instance();
+  if (!globals->cache_dir().empty())
+    checkpoints->set_directory(globals->cache_dir());
+  checkpoints->set_size_limit(size_t(globals->cache_mb()) * 1024 * 1024);
+  checkpoints->set_compression(globals->cache_compression());
+
+  // Thumbnails sent while browsing folders, kept between runs
+  btrgb::ThumbnailCache* thumbnails = btrgb::ThumbnailCache::get_instance();
+  if (!globals->cache_dir().empty())
+    thumbnails->set_directory((std::filesystem::path(globals->cache_dir()) / "thumbnails").string());
+  thumbnails->set_size_limit(size_t(globals->thumbnail_cache_mb()) * 1024 * 1024);
+
+  // Threads shared by OpenCV, OpenMP and the thread pool, split between the running requests
+  btrgb::ThreadBudget::get_instance()->set_total(globals->threads());
+
+  // Decoded files are shared between requests, files shown in previews are decoded before they are submitted
+  btrgb::DecodedImageCache::get_instance()->set_memory_limit(size_t(globals->decode_cache_mb()) * 1024 * 1024);
+  btrgb::DecodePrefetcher::get_instance()->set_memory_limit(size_t(globals->prefetch_mb()) * 1024 * 1024);
+
+  // Tiles of output images, built on the first view
+  btrgb::TilePyramidCache::get_instance()->set_memory_limit(size_t(globals->tile_cache_mb()) * 1024 * 1024);
+
 	bool test = true; // Set to true if you want to test something and bypass the server
 	if (GlobalsSinglton::get_instance()->is_test()) {
 		testFunc();
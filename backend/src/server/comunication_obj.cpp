@@ -2,35 +2,82 @@
 // Defines a class to manage communication between a process and the front end
 //
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <cppcodec/base64_rfc4648.hpp>
 #include "comunication_obj.hpp"
+#include "ImageUtil/ImageWriter/LibpngWriter.hpp"
 
-CommunicationObj::CommunicationObj(server* s, websocketpp::connection_hdl hd1, message_ptr msg) {
+CommunicationObj::CommunicationObj(server* s, websocketpp::connection_hdl hd1, message_ptr msg, OutboundSender* sender) {
 	server_m = s;
+	sender_m = sender;
 	connectionHandle_m = hd1;
 	opcode_m = msg->get_opcode();
 }
 
 CommunicationObj::CommunicationObj(const CommunicationObj &other) {
 	server_m = other.server_m;
+	sender_m = other.sender_m;
 	connectionHandle_m = other.connectionHandle_m;
 	opcode_m = other.opcode_m;
+	encoding_m = other.encoding_m;
 }
 
 void CommunicationObj::send_msg(std::string msg) {
+	if (nullptr != sender_m) {
+		sender_m->post_text(connectionHandle_m, opcode_m, id, std::move(msg));
+		return;
+	}
 	server_m->send(connectionHandle_m, msg, opcode_m);
 }
 
 void CommunicationObj::send_bin(std::vector<uchar>& v){
+	if (nullptr != sender_m) {
+		sender_m->post_binary(connectionHandle_m, id, v);
+		return;
+	}
 	const void* binToSend = (void*)v.data();
 	//Need to find out how to send bin without this send, since it needs a string for what it is sending
 	server_m->send(connectionHandle_m, binToSend, v.size(), websocketpp::frame::opcode::binary);
 }
 
+void CommunicationObj::send_bin(std::vector<uchar>&& v){
+	if (nullptr != sender_m) {
+		sender_m->post_binary(connectionHandle_m, id, std::move(v));
+		return;
+	}
+	send_bin(v);
+}
+
 void CommunicationObj::set_id(long newID){
 	id = newID;
 }
 
+void CommunicationObj::set_encoding(enum btrgb::output_type encoding){
+	encoding_m = encoding;
+}
+
+bool CommunicationObj::encoding_from_name(std::string name, enum btrgb::output_type& encoding){
+	if (name == "png") encoding = btrgb::PNG;
+	else if (name == "jpeg") encoding = btrgb::JPEG;
+	else if (name == "qoi") encoding = btrgb::QOI;
+	else if (name == "rgb") encoding = btrgb::RGB;
+	else return false;
+	return true;
+}
+
+std::string CommunicationObj::mime_type(enum btrgb::output_type type){
+	switch(type) {
+		case btrgb::PNG: return "image/png";
+		case btrgb::JPEG: return "image/jpeg";
+		case btrgb::QOI: return "image/qoi";
+		/* Header and LZ4 block described in Image::getEncoded */
+		case btrgb::RGB: return "application/x-btrgb-rgb-lz4";
+		default: throw std::logic_error("[CommunicationObj::mime_type] Invalid image type. ");
+	}
+}
+
 void CommunicationObj::send_info(std::string msg, std::string sender){
 	jsoncons::json info_body;
 	info_body.insert_or_assign("RequestID", id);
@@ -61,6 +108,15 @@ void CommunicationObj::send_error(std::string msg, std::string sender, bool crit
 }
 
 void CommunicationObj::send_progress(double val, std::string sender){
+	if (nullptr != sender_m) {
+		// Serialized by the sender, only if this update isn't replaced by a newer one first
+		sender_m->post_progress(connectionHandle_m, opcode_m, id, val, sender);
+		return;
+	}
+	send_msg(CommunicationObj::progress_msg(id, val, sender));
+}
+
+std::string CommunicationObj::progress_msg(unsigned long id, double val, std::string sender){
 	jsoncons::json info_body;
 	info_body.insert_or_assign("RequestID", id);
 	info_body.insert_or_assign("ResponseType", "Progress");
@@ -70,8 +126,7 @@ void CommunicationObj::send_progress(double val, std::string sender){
 	info_body.insert_or_assign("ResponseData", response_data);
 	std::string all_info;
 	info_body.dump(all_info);
-	//std::cout<<all_info<<std::endl;
-	send_msg(all_info);
+	return all_info;
 }
 
 void CommunicationObj::send_base64(btrgb::Image* image, enum btrgb::image_quality qual){
@@ -80,8 +135,8 @@ void CommunicationObj::send_base64(btrgb::Image* image, enum btrgb::image_qualit
 }
 
 void CommunicationObj::send_binary(btrgb::Image* image, enum btrgb::image_quality qual){
-	btrgb::binary_ptr_t bin = image->getEncodedPNG(qual);
-	this->send_binary(image->getName(), bin.get(), btrgb::PNG);
+	btrgb::binary_ptr_t bin = image->getEncoded(qual, encoding_m);
+	this->send_binary(image->getName(), bin.get(), encoding_m);
 }
 
 void CommunicationObj::send_base64(
@@ -114,21 +169,94 @@ void CommunicationObj::send_binary(
 	info_body.insert_or_assign("RequestID", id);
 	info_body.insert_or_assign("ResponseType", "ImageBinary");
 	jsoncons::json response_data;
-	switch(type) {
-			case btrgb::PNG: response_data.insert_or_assign("type", "image/png"); break;
-			case btrgb::JPEG: response_data.insert_or_assign("type", "image/jpeg"); break;
-			default: throw std::logic_error("[CommunicationObj::send_binary] Invalid image type. ");
-	}
+	response_data.insert_or_assign("type", CommunicationObj::mime_type(type));
 	response_data.insert_or_assign("name", name);
 	info_body.insert_or_assign("ResponseData", response_data);
 	std::string all_info;
 	info_body.dump(all_info);
-	send_msg(all_info);
 
-	/* Temporarily add binID on and send. */
+	/* The frontend applies the latest header to the next binary, so the two must never be split up
+	 * by a binary sent from another thread (thumbnails and previews are sent from several at once). */
+	if (nullptr != sender_m) {
+		sender_m->post_binary(connectionHandle_m, opcode_m, id, std::move(all_info), *direct_binary);
+		return;
+	}
+	static std::mutex direct_send_mutex;
+	std::unique_lock<std::mutex> lock(direct_send_mutex);
+	send_msg(all_info);
 	send_bin(*direct_binary);
+}
+
+void CommunicationObj::send_image_stream(btrgb::Image* image, enum btrgb::image_quality qual, size_t chunk_size){
+	static std::atomic<uint32_t> next_stream_id{1};
+	uint32_t stream_id = next_stream_id++;
+
+	if (chunk_size == 0)
+		throw std::logic_error("[CommunicationObj::send_image_stream] Chunk size must be positive. ");
+
+	cv::Mat im = image->getDisplayMat(qual);
+
+	jsoncons::json info_body;
+	info_body.insert_or_assign("RequestID", id);
+	info_body.insert_or_assign("ResponseType", "ImageStream");
+	jsoncons::json response_data;
+	response_data.insert_or_assign("streamID", stream_id);
+	response_data.insert_or_assign("name", image->getName());
+	response_data.insert_or_assign("type", "image/png");
+	response_data.insert_or_assign("chunkSize", chunk_size);
+	response_data.insert_or_assign("width", im.cols);
+	response_data.insert_or_assign("height", im.rows);
+	info_body.insert_or_assign("ResponseData", response_data);
+	std::string all_info;
+	info_body.dump(all_info);
+	send_msg(all_info);
 
-	//this->binID++;
+	uint32_t sequence = 0;
+	size_t total = 0;
+	std::vector<uchar> frame;
+	auto start_frame = [&]() {
+		frame.clear();
+		frame.reserve(STREAM_PREFIX_SIZE + chunk_size);
+		for (int i = 0; i < 4; i++)
+			frame.push_back((stream_id >> (8 * i)) & 0xFF);
+		for (int i = 0; i < 4; i++)
+			frame.push_back((sequence >> (8 * i)) & 0xFF);
+	};
+	auto finish_frame = [&]() {
+		// Ownership of the frame goes to the sender, no copy is made
+		send_bin(std::move(frame));
+		sequence++;
+		start_frame();
+	};
+
+	/* Encoded bytes are copied once, from the encoder's buffer into the outgoing frame. */
+	start_frame();
+	btrgb::LibpngWriter writer;
+	writer.stream_png(im, [&](const uint8_t* data, size_t length) {
+		total += length;
+		while (length > 0) {
+			size_t n = std::min(length, STREAM_PREFIX_SIZE + chunk_size - frame.size());
+			frame.insert(frame.end(), data, data + n);
+			data += n;
+			length -= n;
+			if (frame.size() == STREAM_PREFIX_SIZE + chunk_size)
+				finish_frame();
+		}
+	});
+	if (frame.size() > STREAM_PREFIX_SIZE)
+		finish_frame();
+
+	jsoncons::json end_body;
+	end_body.insert_or_assign("RequestID", id);
+	end_body.insert_or_assign("ResponseType", "ImageStreamEnd");
+	jsoncons::json end_data;
+	end_data.insert_or_assign("streamID", stream_id);
+	end_data.insert_or_assign("frames", sequence);
+	end_data.insert_or_assign("size", total);
+	end_body.insert_or_assign("ResponseData", end_data);
+	std::string end_info;
+	end_body.dump(end_info);
+	send_msg(end_info);
 }
 
 void CommunicationObj::send_reports(jsoncons::json reports, std::string report_type) {
@@ -203,3 +331,42 @@ void CommunicationObj::send_post_calibration_msg(std::string results_path){
 	info_body.dump(all_info);
 	send_msg(all_info);
 }
+
+void CommunicationObj::send_calibration_preview(double deltaE, double rmse){
+	jsoncons::json info_body;
+	info_body.insert_or_assign("RequestID", id);
+	info_body.insert_or_assign("ResponseType", "CalibrationPreview");
+	jsoncons::json response_data;
+	response_data.insert_or_assign("deltaE", deltaE);
+	response_data.insert_or_assign("rmse", rmse);
+	info_body.insert_or_assign("ResponseData", response_data);
+	std::string all_info;
+	info_body.dump(all_info);
+	send_msg(all_info);
+}
+
+void CommunicationObj::send_stats(jsoncons::json stats){
+	jsoncons::json info_body;
+	info_body.insert_or_assign("RequestID", id);
+	info_body.insert_or_assign("ResponseType", "Stats");
+	info_body.insert_or_assign("ResponseData", stats);
+	std::string all_info;
+	info_body.dump(all_info);
+	send_msg(all_info);
+}
+
+void CommunicationObj::send_tile_pyramid(std::string name, int width, int height, int levels, int tile_size){
+	jsoncons::json info_body;
+	info_body.insert_or_assign("RequestID", id);
+	info_body.insert_or_assign("ResponseType", "TilePyramid");
+	jsoncons::json response_data;
+	response_data.insert_or_assign("name", name);
+	response_data.insert_or_assign("width", width);
+	response_data.insert_or_assign("height", height);
+	response_data.insert_or_assign("levels", levels);
+	response_data.insert_or_assign("tileSize", tile_size);
+	info_body.insert_or_assign("ResponseData", response_data);
+	std::string all_info;
+	info_body.dump(all_info);
+	send_msg(all_info);
+}
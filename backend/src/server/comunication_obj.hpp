@@ -15,6 +15,7 @@
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
 #include "ImageUtil/Image.hpp"
+#include "server/outbound_sender.hpp"
 
 typedef websocketpp::server<websocketpp::config::asio> server;
 typedef server::message_ptr message_ptr;
@@ -32,21 +33,28 @@ namespace btrgb {
 class CommunicationObj {
 private:
 	server* server_m = NULL;
+	OutboundSender* sender_m = nullptr;
 	websocketpp::connection_hdl connectionHandle_m;
 	websocketpp::frame::opcode::value opcode_m;
 	unsigned long id;
+	enum btrgb::output_type encoding_m = btrgb::PNG;
 	/**
 	* Function for sending a message back to the front end
 	* @param msg: the message string to send
 	*/
 	void send_msg(std::string msg);
 	void send_bin(std::vector<uchar>& v);
+	void send_bin(std::vector<uchar>&& v);
 
     btrgb::base64_ptr_t createDataURL(enum btrgb::output_type type, std::vector<uchar>* direct_binary);
 
 public:
 	CommunicationObj() {};
-	CommunicationObj(server* s, websocketpp::connection_hdl hd1, message_ptr msg);
+	/**
+	* @param sender: the OutboundSender used to send messages,
+	*	if nullptr messages are sent directly from the calling thread
+	*/
+	CommunicationObj(server* s, websocketpp::connection_hdl hd1, message_ptr msg, OutboundSender* sender = nullptr);
 	/**
 	* Copy Constructor
 	*/
@@ -55,6 +63,20 @@ public:
 	//void send_msg(std::string msg);
 	void set_id(long newID);
 	/**
+	* Set how images sent with send_binary(Image*, ...) are encoded, PNG unless the request asks otherwise
+	* @param encoding: PNG, JPEG, QOI or RGB
+	*/
+	void set_encoding(enum btrgb::output_type encoding);
+	/**
+	* Find the encoding named in a request ("png", "jpeg", "qoi" or "rgb")
+	* @return false if the name is unknown
+	*/
+	static bool encoding_from_name(std::string name, enum btrgb::output_type& encoding);
+	/**
+	* The MIME type sent with binary images of the given encoding
+	*/
+	static std::string mime_type(enum btrgb::output_type type);
+	/**
 	* Function for sending a Information Message to the front end
 	* @param msg: the message being sent to the front end
 	* @param sender: what function is sending the message
@@ -74,6 +96,13 @@ public:
 	*/
 	void send_progress(double val, std::string sender);
 	/**
+	* Build the string of a Progress Update Message
+	* @param id: the RequestID the progress belongs to
+	* @param val: amount of progress made in a overall step
+	* @param sender: what function is sending the message
+	*/
+	static std::string progress_msg(unsigned long id, double val, std::string sender);
+	/**
 	* Function for sending a base64 image to the front end
 	* @param image: pointer to the image object of the image being sent
 	* @param type: enum to the type of image being sent
@@ -85,6 +114,12 @@ public:
 	void send_pipeline_components(jsoncons::json compoents_list);
 
 	void send_base64(btrgb::Image* image, enum btrgb::image_quality qual);
+	/**
+	* Function for sending an image as an ImageBinary header followed by the encoded image.
+	* Safe to call from several threads at once, each header is always sent right before its binary.
+	* @param image: pointer to the image object of the image being sent, encoded as set by set_encoding
+	* @param qual: enum for the quality of the image being sent
+	*/
 	void send_binary(btrgb::Image* image, enum btrgb::image_quality qual);
 
 	void send_base64(
@@ -99,7 +134,46 @@ public:
 		enum btrgb::output_type type
 	);
 
+	/**
+	* Function for streaming an image to the front end as a png in fixed size frames.
+	* Frames are sent while the image is still being encoded.
+	* Sends an "ImageStream" message with the streamID, followed by binary frames which each start with
+	* STREAM_PREFIX_SIZE bytes: the streamID then the frame's sequence number (both uint32 little endian).
+	* Every frame holds chunk_size bytes of the png except the last. An "ImageStreamEnd" message
+	* with the streamID, frame count and total size follows the last frame.
+	* @param image: pointer to the image object of the image being sent
+	* @param qual: enum for the quality of the image being sent
+	* @param chunk_size: number of png bytes per frame
+	*/
+	void send_image_stream(btrgb::Image* image, enum btrgb::image_quality qual, size_t chunk_size = STREAM_CHUNK_SIZE);
+
+	static const size_t STREAM_CHUNK_SIZE = 1024 * 1024;
+	static const size_t STREAM_PREFIX_SIZE = 8;
+
 	void send_post_calibration_msg(std::string results_pah);
+
+	/**
+	* Function for sending the results of a calibration run on just the target region
+	* @param deltaE: the resulting CM DeltaE mean
+	* @param rmse: the resulting SP RMSE
+	*/
+	void send_calibration_preview(double deltaE, double rmse);
+
+	/**
+	* Function for sending the state of the backend to the front end
+	* @param stats: the stats built by a StatsRequest
+	*/
+	void send_stats(jsoncons::json stats);
+
+	/**
+	* Function for sending the layout of an image's tile pyramid, ahead of its tiles
+	* @param name: the image the tiles belong to
+	* @param width: full resolution width of the image
+	* @param height: full resolution height of the image
+	* @param levels: number of zoom levels, level 0 is full resolution
+	* @param tile_size: width and height of the tiles, except those on the right and bottom edges
+	*/
+	void send_tile_pyramid(std::string name, int width, int height, int levels, int tile_size);
 };
 
 #endif // COMMUNICATION_OBJ_H
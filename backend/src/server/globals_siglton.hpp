@@ -11,10 +11,36 @@ public:
 	bool is_test();
 	std::string app_root();
 	int get_port();
+	bool float_calibration();
+	int pool_retention_mb();
+	bool huge_pages();
+	std::string scratch_dir();
+	int memory_budget_mb();
+	std::string cache_dir();
+	int cache_mb();
+	bool cache_compression();
+	int threads();
+	int prefetch_mb();
+	int decode_cache_mb();
+	int thumbnail_cache_mb();
+	int tile_cache_mb();
 
 	void set_is_test(bool is_test);
 	void set_app_root(std::string app_root);
 	void set_port(int p);
+	void set_float_calibration(bool use_float);
+	void set_pool_retention_mb(int mb);
+	void set_huge_pages(bool enabled);
+	void set_scratch_dir(std::string dir);
+	void set_memory_budget_mb(int mb);
+	void set_cache_dir(std::string dir);
+	void set_cache_mb(int mb);
+	void set_cache_compression(bool enabled);
+	void set_threads(int threads);
+	void set_prefetch_mb(int mb);
+	void set_decode_cache_mb(int mb);
+	void set_thumbnail_cache_mb(int mb);
+	void set_tile_cache_mb(int mb);
 protected:
 
 private:
@@ -23,6 +49,19 @@ private:
 	bool is_test_m = false;
 	std::string app_root_m = "./";
 	int port = 9002;
+	bool float_calibration_m = true;
+	int pool_retention_mb_m = 1024;
+	bool huge_pages_m = false;
+	std::string scratch_dir_m = "";
+	int memory_budget_mb_m = 0;
+	std::string cache_dir_m = "";
+	int cache_mb_m = 8192;
+	bool cache_compression_m = false;
+	int threads_m = 0;
+	int prefetch_mb_m = 2048;
+	int decode_cache_mb_m = 2048;
+	int thumbnail_cache_mb_m = 256;
+	int tile_cache_mb_m = 1024;
 
 };
 
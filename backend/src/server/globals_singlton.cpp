@@ -39,3 +39,106 @@ int GlobalsSinglton::get_port() {
 	return this->port;
 }
 
+bool GlobalsSinglton::float_calibration() {
+	return this->float_calibration_m;
+}
+
+void GlobalsSinglton::set_float_calibration(bool use_float) {
+	this->float_calibration_m = use_float;
+}
+
+int GlobalsSinglton::pool_retention_mb() {
+	return this->pool_retention_mb_m;
+}
+
+void GlobalsSinglton::set_pool_retention_mb(int mb) {
+	this->pool_retention_mb_m = mb < 0 ? 0 : mb;
+}
+
+bool GlobalsSinglton::huge_pages() {
+	return this->huge_pages_m;
+}
+
+void GlobalsSinglton::set_huge_pages(bool enabled) {
+	this->huge_pages_m = enabled;
+}
+
+std::string GlobalsSinglton::scratch_dir() {
+	return this->scratch_dir_m;
+}
+
+void GlobalsSinglton::set_scratch_dir(std::string dir) {
+	this->scratch_dir_m = dir;
+}
+
+int GlobalsSinglton::memory_budget_mb() {
+	return this->memory_budget_mb_m;
+}
+
+void GlobalsSinglton::set_memory_budget_mb(int mb) {
+	this->memory_budget_mb_m = mb < 0 ? 0 : mb;
+}
+
+std::string GlobalsSinglton::cache_dir() {
+	return this->cache_dir_m;
+}
+
+void GlobalsSinglton::set_cache_dir(std::string dir) {
+	this->cache_dir_m = dir;
+}
+
+int GlobalsSinglton::cache_mb() {
+	return this->cache_mb_m;
+}
+
+void GlobalsSinglton::set_cache_mb(int mb) {
+	this->cache_mb_m = mb < 0 ? 0 : mb;
+}
+
+bool GlobalsSinglton::cache_compression() {
+	return this->cache_compression_m;
+}
+
+void GlobalsSinglton::set_cache_compression(bool enabled) {
+	this->cache_compression_m = enabled;
+}
+
+int GlobalsSinglton::threads() {
+	return this->threads_m;
+}
+
+void GlobalsSinglton::set_threads(int threads) {
+	this->threads_m = threads < 0 ? 0 : threads;
+}
+
+int GlobalsSinglton::prefetch_mb() {
+	return this->prefetch_mb_m;
+}
+
+void GlobalsSinglton::set_prefetch_mb(int mb) {
+	this->prefetch_mb_m = mb < 0 ? 0 : mb;
+}
+
+int GlobalsSinglton::decode_cache_mb() {
+	return this->decode_cache_mb_m;
+}
+
+void GlobalsSinglton::set_decode_cache_mb(int mb) {
+	this->decode_cache_mb_m = mb < 0 ? 0 : mb;
+}
+
+int GlobalsSinglton::thumbnail_cache_mb() {
+	return this->thumbnail_cache_mb_m;
+}
+
+void GlobalsSinglton::set_thumbnail_cache_mb(int mb) {
+	this->thumbnail_cache_mb_m = mb < 0 ? 0 : mb;
+}
+
+int GlobalsSinglton::tile_cache_mb() {
+	return this->tile_cache_mb_m;
+}
+
+void GlobalsSinglton::set_tile_cache_mb(int mb) {
+	this->tile_cache_mb_m = mb < 0 ? 0 : mb;
+}
@@ -0,0 +1,213 @@
+#include "outbound_sender.hpp"
+#include "comunication_obj.hpp"
+
+OutboundSender::OutboundSender(server* s) {
+	this->server_m = s;
+	this->head_m = &this->stub_m;
+	this->tail_m = &this->stub_m;
+	this->thread_m = std::thread(&OutboundSender::run, this);
+}
+
+OutboundSender::~OutboundSender() {
+	this->stopping_m = true;
+	this->wake_m.notify_one();
+	if (this->thread_m.joinable())
+		this->thread_m.join();
+}
+
+void OutboundSender::post_text(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id, std::string msg) {
+	Message* m = new Message;
+	m->kind = Message::TEXT;
+	m->hdl = hdl;
+	m->opcode = opcode;
+	m->request_id = request_id;
+	m->text = std::move(msg);
+	this->post(m);
+}
+
+void OutboundSender::post_binary(websocketpp::connection_hdl hdl, unsigned long request_id, const std::vector<unsigned char>& data) {
+	this->post_binary(hdl, request_id, std::vector<unsigned char>(data));
+}
+
+void OutboundSender::post_binary(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id,
+		std::string header, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> copy(data);
+	this->reserve_binary(copy.size());
+	Message* m = new Message;
+	m->kind = Message::BINARY;
+	m->hdl = hdl;
+	m->opcode = websocketpp::frame::opcode::binary;
+	m->request_id = request_id;
+	m->text = std::move(header);
+	m->text_opcode = opcode;
+	m->binary = std::move(copy);
+	this->post(m);
+}
+
+void OutboundSender::post_binary(websocketpp::connection_hdl hdl, unsigned long request_id, std::vector<unsigned char>&& data) {
+	this->reserve_binary(data.size());
+	Message* m = new Message;
+	m->kind = Message::BINARY;
+	m->hdl = hdl;
+	m->opcode = websocketpp::frame::opcode::binary;
+	m->request_id = request_id;
+	m->binary = std::move(data);
+	this->post(m);
+}
+
+void OutboundSender::reserve_binary(size_t bytes) {
+	// Backpressure, wait for the sender to catch up. A binary larger than the budget is let through once nothing else is queued.
+	// The bytes are counted under the same lock as the check, so producers posting at once can't all pass it.
+	std::unique_lock<std::mutex> lock(this->budget_mutex_m);
+	this->budget_m.wait(lock, [&]() {
+		size_t queued = this->queued_bytes_m;
+		return this->stopping_m || queued == 0 || queued + bytes <= BINARY_BUDGET;
+	});
+	this->queued_bytes_m += bytes;
+}
+
+void OutboundSender::post_progress(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id, double value, std::string sender) {
+	Message* m = new Message;
+	m->kind = Message::PROGRESS;
+	m->hdl = hdl;
+	m->opcode = opcode;
+	m->request_id = request_id;
+	m->text = std::move(sender);
+	m->value = value;
+	this->post(m);
+}
+
+void OutboundSender::post(Message* msg) {
+	this->push(msg);
+	// Not holding wake_mutex_m here so posting never blocks, a missed wakeup costs at most FLUSH_INTERVAL_MS
+	this->wake_m.notify_one();
+}
+
+void OutboundSender::push(Message* msg) {
+	msg->next.store(nullptr, std::memory_order_relaxed);
+	Message* prev = this->head_m.exchange(msg, std::memory_order_acq_rel);
+	prev->next.store(msg, std::memory_order_release);
+}
+
+OutboundSender::Message* OutboundSender::pop() {
+	Message* tail = this->tail_m;
+	Message* next = tail->next.load(std::memory_order_acquire);
+	if (tail == &this->stub_m) {
+		if (nullptr == next)
+			return nullptr;
+		this->tail_m = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+	if (nullptr != next) {
+		this->tail_m = next;
+		return tail;
+	}
+	// tail is the last message, unless a producer is in the middle of a push
+	if (tail != this->head_m.load(std::memory_order_acquire))
+		return nullptr;
+	this->push(&this->stub_m);
+	next = tail->next.load(std::memory_order_acquire);
+	if (nullptr != next) {
+		this->tail_m = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+void OutboundSender::run() {
+	auto last_flush = std::chrono::steady_clock::now();
+	while (true) {
+		// Send everything that is queued
+		Message* msg;
+		while ((msg = this->pop()) != nullptr)
+			this->deliver(msg);
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - last_flush >= std::chrono::milliseconds(FLUSH_INTERVAL_MS)) {
+			this->flush_progress();
+			last_flush = now;
+		}
+
+		if (this->stopping_m) {
+			// Drain anything posted while stopping
+			while ((msg = this->pop()) != nullptr)
+				this->deliver(msg);
+			this->flush_progress();
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(this->wake_mutex_m);
+		this->wake_m.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]() {
+			return this->stopping_m || nullptr != this->tail_m->next.load(std::memory_order_acquire)
+				|| this->tail_m != &this->stub_m;
+		});
+	}
+}
+
+void OutboundSender::deliver(Message* msg) {
+	if (msg->kind == Message::PROGRESS) {
+		// Latest value wins
+		auto key = std::make_pair(msg->request_id, msg->text);
+		auto pending = this->pending_progress_m.find(key);
+		if (pending != this->pending_progress_m.end()) {
+			delete pending->second;
+			pending->second = msg;
+		}
+		else {
+			this->pending_progress_m[key] = msg;
+		}
+		return;
+	}
+
+	// Keep order within the request, progress posted before this message goes first
+	this->flush_progress(msg->request_id);
+	this->write(msg);
+	if (msg->kind == Message::BINARY) {
+		this->queued_bytes_m -= msg->binary.size();
+		std::unique_lock<std::mutex> lock(this->budget_mutex_m);
+		this->budget_m.notify_all();
+	}
+	delete msg;
+}
+
+void OutboundSender::flush_progress() {
+	for (auto& [key, msg] : this->pending_progress_m) {
+		this->write(msg);
+		delete msg;
+	}
+	this->pending_progress_m.clear();
+}
+
+void OutboundSender::flush_progress(unsigned long request_id) {
+	auto it = this->pending_progress_m.lower_bound(std::make_pair(request_id, std::string()));
+	while (it != this->pending_progress_m.end() && it->first.first == request_id) {
+		this->write(it->second);
+		delete it->second;
+		it = this->pending_progress_m.erase(it);
+	}
+}
+
+void OutboundSender::write(Message* msg) {
+	try {
+		switch (msg->kind) {
+			case Message::PROGRESS:
+				this->server_m->send(msg->hdl, CommunicationObj::progress_msg(msg->request_id, msg->value, msg->text), msg->opcode);
+				break;
+			case Message::BINARY:
+				if (!msg->text.empty())
+					this->server_m->send(msg->hdl, msg->text, msg->text_opcode);
+				this->server_m->send(msg->hdl, (void*)msg->binary.data(), msg->binary.size(), msg->opcode);
+				break;
+			default:
+				this->server_m->send(msg->hdl, msg->text, msg->opcode);
+				break;
+		}
+	}
+	catch (const websocketpp::exception& e) {
+		std::cout << "[OutboundSender] Failed to send message: " << e.what() << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cout << "[OutboundSender] Failed to send message: " << e.what() << std::endl;
+	}
+}
@@ -0,0 +1,132 @@
+#ifndef OUTBOUND_SENDER_H
+#define OUTBOUND_SENDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ASIO_STANDALONE
+#define _WEBSOCKETPP_CPP11_THREAD_
+#define _WEBSOCKETPP_CPP11_STRICT_
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+typedef websocketpp::server<websocketpp::config::asio> server;
+
+/*
+Dedicated thread that writes every outbound message to the websocket.
+Processing threads post messages to a lock-free multi-producer/single-consumer queue and return
+right away, so they never wait on websocket I/O. The only exception is binaries: once more than
+BINARY_BUDGET bytes of binaries are waiting to be sent, posting another binary blocks until the
+sender catches up (backpressure). A binary can be posted together with the text message describing
+it, the two are then always sent back to back.
+
+Progress updates are coalesced: only the latest value for each request/sender pair gets sent,
+at most once every FLUSH_INTERVAL_MS. Any pending progress for a request is flushed before the
+next non progress message of that request, so messages of a request are always received in the
+order they were posted.
+*/
+class OutboundSender {
+
+public:
+	OutboundSender(server* s);
+	/*
+	Sends anything still queued then stops the sender thread
+	*/
+	~OutboundSender();
+
+	/*
+	Queue a text message
+	@param hdl: the connection to send to
+	@param opcode: the websocket opcode to send with
+	@param request_id: the request this message belongs to
+	@param msg: the message
+	*/
+	void post_text(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id, std::string msg);
+
+	/*
+	Queue a binary message, this blocks if too many bytes of binaries are already waiting to be sent
+	@param hdl: the connection to send to
+	@param request_id: the request this message belongs to
+	@param data: the binary, copied
+	*/
+	void post_binary(websocketpp::connection_hdl hdl, unsigned long request_id, const std::vector<unsigned char>& data);
+
+	/*
+	Same as above, but takes ownership of the binary instead of copying it
+	*/
+	void post_binary(websocketpp::connection_hdl hdl, unsigned long request_id, std::vector<unsigned char>&& data);
+
+	/*
+	Queue a text message and the binary it describes as one entry, nothing else gets sent between the two
+	even when several threads post at once. Blocks like post_binary
+	@param opcode: the websocket opcode to send the header with
+	@param header: the text message sent right before the binary
+	@param data: the binary, copied
+	*/
+	void post_binary(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id,
+		std::string header, const std::vector<unsigned char>& data);
+
+	/*
+	Queue a progress update, this may be merged with other updates from the same request and sender
+	@param hdl: the connection to send to
+	@param opcode: the websocket opcode to send with
+	@param request_id: the request this update belongs to
+	@param value: the progress value
+	@param sender: what is reporting progress
+	*/
+	void post_progress(websocketpp::connection_hdl hdl, websocketpp::frame::opcode::value opcode, unsigned long request_id, double value, std::string sender);
+
+	static const int FLUSH_INTERVAL_MS = 50;
+	static const size_t BINARY_BUDGET = 64 * 1024 * 1024;
+
+private:
+	struct Message {
+		enum Kind { TEXT, BINARY, PROGRESS } kind = TEXT;
+		websocketpp::connection_hdl hdl;
+		websocketpp::frame::opcode::value opcode = websocketpp::frame::opcode::text;
+		unsigned long request_id = 0;
+		std::string text; // message for TEXT, sender for PROGRESS, header sent before a BINARY if not empty
+		websocketpp::frame::opcode::value text_opcode = websocketpp::frame::opcode::text;
+		std::vector<unsigned char> binary;
+		double value = 0;
+		std::atomic<Message*> next{nullptr};
+	};
+
+	server* server_m;
+
+	/* Intrusive MPSC queue (Vyukov). Producers only touch head_m, the sender thread owns tail_m. */
+	std::atomic<Message*> head_m;
+	Message* tail_m;
+	Message stub_m;
+	void push(Message* msg);
+	Message* pop();
+
+	/* Latest progress of each request/sender, only touched by the sender thread. */
+	std::map<std::pair<unsigned long, std::string>, Message*> pending_progress_m;
+
+	std::thread thread_m;
+	std::atomic<bool> stopping_m{false};
+	std::mutex wake_mutex_m;
+	std::condition_variable wake_m;
+
+	std::atomic<size_t> queued_bytes_m{0};
+	std::mutex budget_mutex_m;
+	std::condition_variable budget_m;
+
+	void post(Message* msg);
+	// Waits for room in BINARY_BUDGET, then counts bytes as queued
+	void reserve_binary(size_t bytes);
+	void run();
+	void deliver(Message* msg);
+	void flush_progress();
+	void flush_progress(unsigned long request_id);
+	void write(Message* msg);
+};
+
+#endif // OUTBOUND_SENDER_H
@@ -4,6 +4,13 @@
 
 #include <iostream>
 
+ProcessManager::ProcessManager() {
+	// Nothing is running, buffers kept for the next stage would only hold on to memory
+	this->scheduler_m.set_idle_callback([]() {
+		btrgb::BufferPool::get_instance()->trim();
+	});
+}
+
 void ProcessManager::process_request(std::string request, std::shared_ptr<CommunicationObj> coms_obj) {
 	this->set_coms_obj(coms_obj);
 	std::cout << "Received: " << request << std::endl;
@@ -20,12 +27,55 @@ void ProcessManager::process_request(std::string request, std::shared_ptr<Commun
 		Json request_data = j.get_obj(RequestDataKey);
 		coms_obj->set_id(request_id);
 
+		// Cancel a queued or running process
+		if (request_key == "Cancel") {
+			unsigned long cancel_id = request_data.get_number(RequestIDKey);
+			if (this->cancel_process(cancel_id))
+				coms_obj->send_info("Request " + std::to_string(cancel_id) + " cancelled.", "ProcessManager");
+			else
+				coms_obj->send_error("No active request with id " + std::to_string(cancel_id) + ".", "ProcessManager", btrgb::BENING);
+			return;
+		}
+
+		// Optional encoding of the images sent back, the frontend picks the fastest for each view
+		if (request_data.has("encoding", Json::Type::STRING)) {
+			enum btrgb::output_type encoding;
+			if (!CommunicationObj::encoding_from_name(request_data.get_string("encoding"), encoding)) {
+				this->report_error("ProcessManager", "Unknown encoding");
+				return;
+			}
+			coms_obj->set_encoding(encoding);
+		}
+
 		// Create process
 		std::shared_ptr<BackendProcess> process = identify_process(request_key);
+		if (nullptr == process) {
+			this->report_error("ProcessManager", "Unknown RequestType");
+			return;
+		}
+
+		// Optional deadline for the whole request
+		std::shared_ptr<btrgb::CancellationToken> token = process->get_cancellation_token();
+		if (request_data.has("deadline", Json::Type::NUMBER))
+			token->set_deadline(request_data.get_number("deadline"));
+		{
+			std::unique_lock<std::mutex> lock(this->active_mutex_m);
+			this->active_m[request_id] = {token, process};
+		}
 
-		//Start processing thread
-		std::thread p_thread(&ProcessManager::start_process, this, process, coms_obj, request_data);
-		p_thread.detach();
+		// Queue process to be run by the scheduler
+		ProcessScheduler::Lane lane = identify_lane(request_key);
+		bool accepted = this->scheduler_m.submit(lane, [this, process, coms_obj, request_data, request_id]() {
+			this->start_process(process, coms_obj, request_data, request_id);
+		});
+		if (!accepted) {
+			static btrgb::Counter& rejected = btrgb::Metrics::counter("requests.rejected");
+			rejected.add();
+			std::unique_lock<std::mutex> lock(this->active_mutex_m);
+			this->active_m.erase(request_id);
+			lock.unlock();
+			coms_obj->send_error("Server is busy, too many " + ProcessScheduler::lane_name(lane) + " requests are waiting. Try again later.", "ProcessManager");
+		}
 	}
 	catch (ParsingError e) {
 		this->report_error("ProcessManager", e.what());
@@ -54,11 +104,69 @@ std::shared_ptr<BackendProcess> ProcessManager::identify_process(std::string key
 	else if (key == "Reports")
 		process = std::shared_ptr<ReportRequest>(new ReportRequest(key));
 	
+	else if (key == "Stats")
+		process = std::shared_ptr<StatsRequest>(new StatsRequest(key, [this]() { return this->server_stats(); }));
+	
+	else if (key == "Tile")
+		process = std::shared_ptr<TileRequest>(new TileRequest(key));
+	
 
 	return process;
 }
 
-void ProcessManager::start_process(std::shared_ptr<BackendProcess> process, std::shared_ptr<CommunicationObj> coms_obj, Json request_data) {
+ProcessScheduler::Lane ProcessManager::identify_lane(std::string key) {
+	if (key == "Process")
+		return ProcessScheduler::BATCH;
+	if (key == "HalfSizePreview" || key == "Thumbnails")
+		return ProcessScheduler::PREVIEW;
+	// SpectralPicker, ColorManagedImage, Tile, Reports, Stats
+	return ProcessScheduler::INTERACTIVE;
+}
+
+ProcessManager::~ProcessManager() {
+	std::unique_lock<std::mutex> lock(this->active_mutex_m);
+	for (auto& [id, active] : this->active_m)
+		active.token->cancel();
+}
+
+bool ProcessManager::cancel_process(unsigned long request_id) {
+	std::unique_lock<std::mutex> lock(this->active_mutex_m);
+	if (!this->active_m.contains(request_id))
+		return false;
+	this->active_m[request_id].token->cancel();
+	return true;
+}
+
+jsoncons::json ProcessManager::server_stats() {
+	jsoncons::json lanes;
+	for (int lane = 0; lane < ProcessScheduler::LANE_COUNT; lane++) {
+		jsoncons::json lane_stats;
+		lane_stats.insert_or_assign("queued", this->scheduler_m.queued_count((ProcessScheduler::Lane) lane));
+		lane_stats.insert_or_assign("running", this->scheduler_m.running_count((ProcessScheduler::Lane) lane));
+		lanes.insert_or_assign(ProcessScheduler::lane_name((ProcessScheduler::Lane) lane), lane_stats);
+	}
+
+	jsoncons::json requests = jsoncons::json::make_array();
+	std::unique_lock<std::mutex> lock(this->active_mutex_m);
+	for (auto& [id, active] : this->active_m) {
+		std::shared_ptr<btrgb::MemoryAccount> memory = active.process->get_memory_account();
+		jsoncons::json request;
+		request.insert_or_assign("RequestID", id);
+		request.insert_or_assign("process", active.process->get_process_name());
+		request.insert_or_assign("stage", memory->stage());
+		request.insert_or_assign("matBytes", memory->current_bytes());
+		request.insert_or_assign("peakMatBytes", memory->peak_bytes());
+		requests.push_back(request);
+	}
+	lock.unlock();
+
+	jsoncons::json stats;
+	stats.insert_or_assign("requests", requests);
+	stats.insert_or_assign("lanes", lanes);
+	return stats;
+}
+
+void ProcessManager::start_process(std::shared_ptr<BackendProcess> process, std::shared_ptr<CommunicationObj> coms_obj, Json request_data, unsigned long request_id) {
 	std::cout << "Finalizing Process Initialization" << std::endl;
 	if (nullptr == process) {
 		this->report_error("ProcessManager", "Unknown RequestType");
@@ -66,7 +174,23 @@ void ProcessManager::start_process(std::shared_ptr<BackendProcess> process, std:
 	}
 	process->set_coms_obj(coms_obj);
 	process->set_process_data(request_data);
-	std::cout << "Starting Process" << std::endl;
-	process->run();
-	std::cout << process->get_process_name() << " complete." << std::endl;
+	// Charge every Mat the process allocates on this thread to it
+	btrgb::MemoryAccount::Bind memory_bind(process->get_memory_account().get());
+	// Share the threads with the other running requests
+	btrgb::ThreadBudget::Share thread_share;
+	// Cancelled while still waiting in the queue
+	if (process->get_cancellation_token()->is_cancelled()) {
+		coms_obj->send_error(btrgb::OperationCancelled().what(), process->get_process_name());
+	}
+	else {
+		std::cout << "Starting Process" << std::endl;
+		static btrgb::Counter& started = btrgb::Metrics::counter("requests.started");
+		started.add();
+		process->run();
+		std::cout << process->get_process_name() << " complete." << std::endl;
+	}
+	std::unique_lock<std::mutex> lock(this->active_mutex_m);
+	// Only remove the entry if it still belongs to this process
+	if (this->active_m.contains(request_id) && this->active_m[request_id].process == process)
+		this->active_m.erase(request_id);
 }
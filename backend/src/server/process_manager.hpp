@@ -2,10 +2,13 @@
 #define PROCESS_MANAGER_H
 
 #include <thread>
+#include <mutex>
+#include <unordered_map>
 
 #include <iostream>
 #include "comunication_obj.hpp"
 #include "communicator.hpp"
+#include "process_scheduler.hpp"
 #include "backend_process/backend_process.hpp"
 #include "backend_process/pipeline.hpp"
 #include "backend_process/ColorManagedImage.hpp"
@@ -13,7 +16,11 @@
 #include "backend_process/HalfSizePreview.hpp"
 #include "backend_process/ThumbnailLoader.hpp"
 #include "backend_process/ReportRequest.hpp"
+#include "backend_process/StatsRequest.hpp"
+#include "backend_process/TileRequest.hpp"
 #include "utils/json.hpp"
+#include "utils/buffer_pool.hpp"
+#include "utils/thread_budget.hpp"
 
 /*
 Class that magages parsing requests, and spinning up processing threads
@@ -22,7 +29,17 @@ It is converted to a Json object (expected format as follows)
 	{  "RequestType": <request identifying string>,
 		"RequestData": <json object> }
 The RequestType is used to identify what process to start.
-Once the process is identified and created a new thread is started to run the process
+A RequestType of "Stats" reports what the backend is doing: active requests and their stage,
+queue depth of each lane, memory use and the metrics registry (cache hit rates, throughput, ...).
+A RequestType of "Tile" sends tiles of a project's color managed image (see TileRequest).
+A RequestType of "Cancel" cancels the process started by the request whose id is given
+in the RequestData ({"RequestID": <id>}).
+Any request may give an optional "deadline" in its RequestData (milliseconds), once it passes
+the process gets cancelled.
+Any request may also give an optional "encoding" for the images it gets back
+("png" by default, "jpeg", "qoi" or "rgb"), ImageBinary messages carry the matching MIME type.
+Once the process is identified and created it is submitted to the ProcessScheduler which
+runs it on a bounded pool of workers, in a lane based on the RequestType
 */
 class ProcessManager : public Communicator {
 
@@ -41,7 +58,14 @@ class ProcessManager : public Communicator {
 	};
 
 public:
-	ProcessManager() {};
+	/*
+	Returns pooled image buffers to the OS whenever the scheduler goes idle
+	*/
+	ProcessManager();
+	/*
+	Cancels every process that is still queued or running so the scheduler can shut down
+	*/
+	~ProcessManager();
 	/*
 	Process request string and start matching process thread
 	@param request: the request string sent from the front end
@@ -51,6 +75,33 @@ public:
 
 private:
 	std::string name_m = "ProcessManager";
+	struct ActiveRequest {
+		std::shared_ptr<btrgb::CancellationToken> token;
+		std::shared_ptr<BackendProcess> process;
+	};
+	// All queued and running processes, keyed by RequestID
+	std::unordered_map<unsigned long, ActiveRequest> active_m;
+	std::mutex active_mutex_m;
+	// Declared after active_m so it is destroyed (and its workers joined) first
+	ProcessScheduler scheduler_m;
+	/*
+	Cancel the process started by the given request
+	@param request_id: the RequestID of the request to cancel
+	@return true if a process was found and cancelled
+	*/
+	bool cancel_process(unsigned long request_id);
+	/*
+	Build the ProcessManager's part of a Stats response
+	@return json with "requests": the id, process name, current stage and memory use of each
+		queued or running request, and "lanes": the queued and running count of each scheduler lane
+	*/
+	jsoncons::json server_stats();
+	/*
+	Identifys the ProcessScheduler lane a request should run in
+	@param key: the RequestType of the request
+	@return the lane
+	*/
+	ProcessScheduler::Lane identify_lane(std::string key);
 	/*
 	Identifys and creates the requested process.
 	@param key: the key identifying what process to create,
@@ -65,7 +116,7 @@ private:
 	@param process: the BackendProcess to run
 	@param coms_obj: the CommunicationObj to be used for the process to communicate witht the frontend
 	*/
-	void start_process(std::shared_ptr <BackendProcess> process, std::shared_ptr<CommunicationObj> coms_obj, Json request_data);
+	void start_process(std::shared_ptr <BackendProcess> process, std::shared_ptr<CommunicationObj> coms_obj, Json request_data, unsigned long request_id);
 
 	std::string sample_request = R"({
 		"RequestType":"processImg",
@@ -0,0 +1,130 @@
+#include "process_scheduler.hpp"
+
+#include <iostream>
+
+ProcessScheduler::ProcessScheduler(int worker_count) {
+	// Defaults, interactive requests are small and should never wait behind anything else
+	this->set_lane_limits(INTERACTIVE, 2, 16);
+	this->set_lane_limits(PREVIEW, 1, 8);
+	this->set_lane_limits(BATCH, 1, 2);
+
+	if (worker_count < 1)
+		worker_count = 1;
+	for (int i = 0; i < worker_count; i++)
+		this->workers_m.push_back(std::thread(&ProcessScheduler::worker_loop, this));
+}
+
+ProcessScheduler::~ProcessScheduler() {
+	{
+		std::unique_lock<std::mutex> lock(this->mutex_m);
+		this->stopping_m = true;
+	}
+	this->job_ready_m.notify_all();
+	for (std::thread& worker : this->workers_m) {
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+bool ProcessScheduler::submit(Lane lane, job_t job) {
+	{
+		std::unique_lock<std::mutex> lock(this->mutex_m);
+		LaneState& state = this->lanes_m[lane];
+		if (this->stopping_m || (int)state.queue.size() >= state.max_queued)
+			return false;
+		state.queue.push_back(std::move(job));
+	}
+	this->job_ready_m.notify_one();
+	return true;
+}
+
+void ProcessScheduler::set_lane_limits(Lane lane, int max_running, int max_queued) {
+	{
+		std::unique_lock<std::mutex> lock(this->mutex_m);
+		this->lanes_m[lane].max_running = max_running < 1 ? 1 : max_running;
+		this->lanes_m[lane].max_queued = max_queued < 0 ? 0 : max_queued;
+	}
+	this->job_ready_m.notify_all();
+}
+
+int ProcessScheduler::queued_count(Lane lane) {
+	std::unique_lock<std::mutex> lock(this->mutex_m);
+	return this->lanes_m[lane].queue.size();
+}
+
+int ProcessScheduler::running_count(Lane lane) {
+	std::unique_lock<std::mutex> lock(this->mutex_m);
+	return this->lanes_m[lane].running;
+}
+
+void ProcessScheduler::set_idle_callback(job_t callback) {
+	std::unique_lock<std::mutex> lock(this->mutex_m);
+	this->idle_callback_m = callback;
+}
+
+bool ProcessScheduler::is_idle() {
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		if (this->lanes_m[lane].running > 0 || !this->lanes_m[lane].queue.empty())
+			return false;
+	}
+	return true;
+}
+
+std::string ProcessScheduler::lane_name(Lane lane) {
+	switch (lane) {
+		case INTERACTIVE: return "Interactive";
+		case PREVIEW: return "Preview";
+		case BATCH: return "Batch";
+		default: return "Unknown";
+	}
+}
+
+ProcessScheduler::Lane ProcessScheduler::next_lane() {
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		LaneState& state = this->lanes_m[lane];
+		if (!state.queue.empty() && state.running < state.max_running)
+			return (Lane)lane;
+	}
+	return LANE_COUNT;
+}
+
+void ProcessScheduler::worker_loop() {
+	std::unique_lock<std::mutex> lock(this->mutex_m);
+	while (true) {
+		Lane lane;
+		this->job_ready_m.wait(lock, [&]() {
+			lane = this->next_lane();
+			return this->stopping_m || lane != LANE_COUNT;
+		});
+		if (this->stopping_m)
+			return;
+
+		LaneState& state = this->lanes_m[lane];
+		job_t job = std::move(state.queue.front());
+		state.queue.pop_front();
+		state.running++;
+
+		lock.unlock();
+		try {
+			job();
+		}
+		catch (const std::exception& e) {
+			std::cout << "[ProcessScheduler] Uncaught error in " << lane_name(lane) << " job: " << e.what() << std::endl;
+		}
+		catch (...) {
+			std::cout << "[ProcessScheduler] Uncaught error in " << lane_name(lane) << " job." << std::endl;
+		}
+		lock.lock();
+
+		state.running--;
+		// A slot in this lane just opened up, any waiting worker may now be able to take a job from it
+		this->job_ready_m.notify_all();
+
+		if (this->idle_callback_m && this->is_idle()) {
+			job_t idle_callback = this->idle_callback_m;
+			lock.unlock();
+			idle_callback();
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,118 @@
+#ifndef PROCESS_SCHEDULER_H
+#define PROCESS_SCHEDULER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Bounded worker pool that runs BackendProcesses.
+Each job is submitted to a lane. Lanes are visited in priority order (INTERACTIVE first)
+whenever a worker is free, but a lane can only have a limited number of jobs running at once
+and a limited number of jobs waiting. When a lane's queue is full new jobs are rejected (admission control).
+
+Since the worker count is lower than the sum of the lane limits a running Pipeline and a burst
+of preview requests can not take every worker away from interactive requests.
+*/
+class ProcessScheduler {
+
+public:
+	enum Lane {
+		INTERACTIVE,	// SpectralPicker, ColorManagedImage, Reports
+		PREVIEW,		// Thumbnails, HalfSizePreview
+		BATCH,			// Pipeline
+		LANE_COUNT
+	};
+
+	typedef std::function<void()> job_t;
+
+	/**
+	* Start the workers
+	* @param worker_count: the total number of jobs that can run at once
+	*/
+	ProcessScheduler(int worker_count = DEFAULT_WORKER_COUNT);
+
+	/**
+	* Stops the workers once the jobs already running have finished. Queued jobs are dropped.
+	*/
+	~ProcessScheduler();
+
+	/**
+	* Queue a job to be run
+	* @param lane: the lane to run the job in
+	* @param job: the job to run
+	* @return true if the job was queued, false if the lane's queue is full
+	*/
+	bool submit(Lane lane, job_t job);
+
+	/**
+	* Set the limits of a lane
+	* @param lane: the lane to set limits for
+	* @param max_running: the max number of jobs from this lane that can run at once
+	* @param max_queued: the max number of jobs that can wait in this lane
+	*/
+	void set_lane_limits(Lane lane, int max_running, int max_queued);
+
+	/**
+	* Get the number of jobs waiting in a lane
+	*/
+	int queued_count(Lane lane);
+
+	/**
+	* Get the number of jobs running from a lane
+	*/
+	int running_count(Lane lane);
+
+	/**
+	* Set a callback run whenever the last running job finishes and nothing is queued.
+	* It runs on the worker that finished the job, outside of the scheduler's lock.
+	*/
+	void set_idle_callback(job_t callback);
+
+	/**
+	* Get the display name of a lane
+	*/
+	static std::string lane_name(Lane lane);
+
+	static const int DEFAULT_WORKER_COUNT = 3;
+
+private:
+	struct LaneState {
+		std::deque<job_t> queue;
+		int running = 0;
+		int max_running = 1;
+		int max_queued = 8;
+	};
+
+	LaneState lanes_m[LANE_COUNT];
+	std::vector<std::thread> workers_m;
+	std::mutex mutex_m;
+	std::condition_variable job_ready_m;
+	bool stopping_m = false;
+	job_t idle_callback_m;
+
+	/*
+	Run jobs until the scheduler is stopped
+	*/
+	void worker_loop();
+
+	/*
+	Find the highest priority lane that has a job waiting and room to run it.
+	mutex_m must be held.
+	@return the lane or LANE_COUNT if nothing can run
+	*/
+	Lane next_lane();
+
+	/*
+	Check if no jobs are running or waiting.
+	mutex_m must be held.
+	*/
+	bool is_idle();
+
+};
+
+#endif // PROCESS_SCHEDULER_H
@@ -55,7 +55,7 @@ void RequestServer::msg_handler(server* s, websocketpp::connection_hdl hdl, mess
         return;
     }
     
-    std::shared_ptr<CommunicationObj> coms_obj = std::shared_ptr<CommunicationObj>(new CommunicationObj( s, hdl, msg));
+    std::shared_ptr<CommunicationObj> coms_obj = std::shared_ptr<CommunicationObj>(new CommunicationObj( s, hdl, msg, &this->sender_m));
     this->process_manager_m.process_request(msg->get_payload(), coms_obj);
 }
 
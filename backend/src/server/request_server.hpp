@@ -10,6 +10,7 @@
 #include "server/globals_siglton.hpp"
 #include "comunication_obj.hpp"
 #include "process_manager.hpp"
+#include "outbound_sender.hpp"
 
 typedef websocketpp::server<websocketpp::config::asio> server;
 typedef server::message_ptr message_ptr;
@@ -21,6 +22,8 @@ class RequestServer {
 	
 private:
 	server server_m;
+	// Declared before process_manager_m so it outlives every process that may still be sending
+	OutboundSender sender_m{&server_m};
 	ProcessManager process_manager_m;
 	/**
 	* Handler that gets called any time a new msg comes in on port_m
@@ -0,0 +1,70 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace btrgb {
+
+    /**
+     * @brief Queue between a producing and a consuming thread that holds at most capacity items
+     *
+     * push() blocks while the queue is full so a fast producer can't get further ahead of the consumer
+     * than the capacity allows. Either side calls close() to stop the other, e.g. when it fails.
+     */
+    template <typename T>
+    class BoundedQueue {
+    public:
+        BoundedQueue(size_t capacity) {
+            this->capacity = capacity;
+        }
+
+        /**
+         * @brief Add an item, waiting for room if the queue is full
+         * @return false if the queue was closed, the item was not added
+         */
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->not_full.wait(lock, [this]() { return this->closed || this->items.size() < this->capacity; });
+            if (this->closed)
+                return false;
+            this->items.push_back(std::move(item));
+            this->not_empty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Take the next item, waiting for one if the queue is empty
+         * @return false once the queue is closed and everything pushed before that has been taken
+         */
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->not_empty.wait(lock, [this]() { return this->closed || !this->items.empty(); });
+            if (this->items.empty())
+                return false;
+            item = std::move(this->items.front());
+            this->items.pop_front();
+            this->not_full.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->closed = true;
+            this->not_full.notify_all();
+            this->not_empty.notify_all();
+        }
+
+    private:
+        size_t capacity;
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+        std::deque<T> items;
+        bool closed = false;
+    };
+
+}
+
+#endif // BOUNDED_QUEUE_H
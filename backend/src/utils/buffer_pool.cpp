@@ -0,0 +1,191 @@
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+#include "buffer_pool.hpp"
+#include "utils/metrics.hpp"
+
+namespace btrgb {
+
+    /* ============[ BufferPool ]============== */
+
+    BufferPool* BufferPool::get_instance() {
+        // Never deleted, Mats may be freed during static destruction
+        static BufferPool* instance = new BufferPool;
+        return instance;
+    }
+
+    void BufferPool::set_retention_cap(size_t bytes) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->retention_cap = bytes;
+        }
+        if (this->retained_bytes() > bytes)
+            this->trim();
+    }
+
+    void BufferPool::set_huge_pages(bool enabled) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->huge_pages = enabled;
+    }
+
+    size_t BufferPool::size_class(size_t size) {
+        // Round up to the next of 8 steps between consecutive powers of two
+        size_t power = 1;
+        while (power * 2 < size)
+            power *= 2;
+        size_t step = power / 8;
+        return ((size + step - 1) / step) * step;
+    }
+
+    void* BufferPool::acquire(size_t size) {
+        static Counter& hits = Metrics::counter("bufferPool.hits");
+        static Counter& misses = Metrics::counter("bufferPool.misses");
+        static Gauge& retained_gauge = Metrics::gauge("bufferPool.retainedBytes");
+
+        size_t class_size = BufferPool::size_class(size);
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            std::vector<void*>& buffers = this->free_buffers[class_size];
+            if (!buffers.empty()) {
+                void* buffer = buffers.back();
+                buffers.pop_back();
+                this->retained -= class_size;
+                retained_gauge.set(this->retained);
+                hits.add();
+                return buffer;
+            }
+        }
+        misses.add();
+        void* buffer = this->map(class_size);
+        if (nullptr == buffer) {
+            // Out of address space/memory, what is retained may be enough to make it fit
+            this->trim();
+            buffer = this->map(class_size);
+            if (nullptr == buffer)
+                throw std::bad_alloc();
+        }
+        return buffer;
+    }
+
+    void BufferPool::release(void* buffer, size_t size) {
+        static Gauge& retained_gauge = Metrics::gauge("bufferPool.retainedBytes");
+
+        size_t class_size = BufferPool::size_class(size);
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (this->retained + class_size <= this->retention_cap) {
+                this->free_buffers[class_size].push_back(buffer);
+                this->retained += class_size;
+                retained_gauge.set(this->retained);
+                return;
+            }
+        }
+        BufferPool::unmap(buffer, class_size);
+    }
+
+    void BufferPool::trim() {
+        static Gauge& retained_gauge = Metrics::gauge("bufferPool.retainedBytes");
+
+        std::map<size_t, std::vector<void*>> buffers;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            buffers.swap(this->free_buffers);
+            this->retained = 0;
+            retained_gauge.set(0);
+        }
+        for (auto& [class_size, class_buffers] : buffers) {
+            for (void* buffer : class_buffers)
+                BufferPool::unmap(buffer, class_size);
+        }
+    }
+
+    size_t BufferPool::retained_bytes() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->retained;
+    }
+
+    void* BufferPool::map(size_t size) {
+#if defined(_WIN32)
+        // Large pages on Windows need a privilege users don't have, regular pages are used
+        return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        void* buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
+            return nullptr;
+    #if defined(MADV_HUGEPAGE)
+        bool huge_pages;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            huge_pages = this->huge_pages;
+        }
+        if (huge_pages)
+            madvise(buffer, size, MADV_HUGEPAGE);
+    #endif
+        return buffer;
+#endif
+    }
+
+    void BufferPool::unmap(void* buffer, size_t size) {
+#if defined(_WIN32)
+        VirtualFree(buffer, 0, MEM_RELEASE);
+#else
+        munmap(buffer, size);
+#endif
+    }
+
+    /* ============[ PooledMatAllocator ]============== */
+
+    cv::UMatData* PooledMatAllocator::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+
+        // Same layout as OpenCV's standard allocator
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                }
+                else {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+
+        uchar* data = (uchar*) data0;
+        if (nullptr == data)
+            data = (total >= BufferPool::MIN_POOLED_SIZE) ? (uchar*) BufferPool::get_instance()->acquire(total) : (uchar*) cv::fastMalloc(total);
+
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = data;
+        u->size = total;
+        if (nullptr != data0)
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    bool PooledMatAllocator::allocate(cv::UMatData* u, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const {
+        return nullptr != u;
+    }
+
+    void PooledMatAllocator::deallocate(cv::UMatData* u) const {
+        if (nullptr == u)
+            return;
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            if (u->size >= BufferPool::MIN_POOLED_SIZE)
+                BufferPool::get_instance()->release(u->origdata, u->size);
+            else
+                cv::fastFree(u->origdata);
+            u->origdata = 0;
+        }
+        delete u;
+    }
+
+}
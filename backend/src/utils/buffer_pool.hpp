@@ -0,0 +1,90 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief Keeps freed large image buffers around so the next stage can reuse them
+     * instead of going back to the OS (page faults, fragmentation, climbing RSS).
+     *
+     * Buffers of at least MIN_POOLED_SIZE bytes are rounded up to a size class, eight classes per
+     * doubling so at most 12.5% is wasted. Freed buffers stay in the pool until retaining them would
+     * go over the retention cap, or trim() is called (the backend calls it whenever it goes idle).
+     *
+     * Buffers come straight from the OS (mmap/VirtualAlloc). When huge pages are enabled
+     * the kernel is asked to back them with huge pages where that is supported (Linux).
+     */
+    class BufferPool {
+    public:
+        static const size_t MIN_POOLED_SIZE = 1024 * 1024;
+
+        static BufferPool* get_instance();
+
+        /**
+         * @brief Set the most bytes of free buffers to keep, 0 keeps none
+         */
+        void set_retention_cap(size_t bytes);
+        void set_huge_pages(bool enabled);
+
+        /**
+         * @brief Get a buffer of at least size bytes
+         * @param size at least MIN_POOLED_SIZE
+         * @return the buffer, it must be given back with release() using the same size
+         */
+        void* acquire(size_t size);
+
+        /**
+         * @brief Give a buffer back, it is kept for reuse if the retention cap allows it
+         */
+        void release(void* buffer, size_t size);
+
+        /**
+         * @brief Return every retained buffer to the OS
+         */
+        void trim();
+
+        size_t retained_bytes();
+
+        /**
+         * @brief The size a buffer of the given size is rounded up to
+         */
+        static size_t size_class(size_t size);
+
+    private:
+        BufferPool() {}
+
+        std::mutex mutex;
+        // Free buffers of each size class
+        std::map<size_t, std::vector<void*>> free_buffers;
+        size_t retained = 0;
+        size_t retention_cap = 1024 * 1024 * 1024;
+        bool huge_pages = false;
+
+        void* map(size_t size);
+        static void unmap(void* buffer, size_t size);
+    };
+
+    /**
+     * @brief Allocates Mat data of MIN_POOLED_SIZE and over from the BufferPool,
+     * anything smaller the same way OpenCV's standard allocator does.
+     */
+    class PooledMatAllocator : public cv::MatAllocator {
+    public:
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+            cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+        bool allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const override;
+        void deallocate(cv::UMatData* data) const override;
+    };
+
+}
+
+#endif // BUFFER_POOL_H
@@ -1,4 +1,6 @@
 #include "calibration_util.hpp"
+#include "utils/thread_pool.hpp"
+#include <cmath>
 
 cv::Mat btrgb::calibration::build_target_avg_matrix(ColorTarget targets[], int target_count, int channel_count){
     int row_count = targets[0].get_row_count();
@@ -15,6 +17,8 @@ cv::Mat btrgb::calibration::build_target_avg_matrix(ColorTarget targets[], int t
     std::cout << "Filling Matrix" << std::endl;
     for (int target_i = 0; target_i < target_count; target_i++) {
         ColorTarget target = targets[target_i];
+        // Stats for every patch and channel of the current Target, computed in parallel
+        std::vector<PatchStats> patch_stats = target.get_all_patch_stats(channel_count);
         // For each Target visit each Channel
         for (int chan = 0; chan < channel_count; chan++) {
             // Calculate the row of matrex to put data
@@ -24,8 +28,8 @@ cv::Mat btrgb::calibration::build_target_avg_matrix(ColorTarget targets[], int t
                 for (int target_col = 0; target_col < col_count; target_col++) {
                     // Calculate the colum of matrix to put data
                     int mat_col = target_col + target_row * col_count;
-                    // Get avg pixel color for current ColorPatch
-                    float avg = target.get_patch_avg(target_row, target_col, chan);
+                    // Get avg pixel color for current ColorPatch, the targets statistic decides what "avg" is (mean, median, trimmed mean)
+                    float avg = target.select_statistic(patch_stats[mat_col * channel_count + chan]);
                     // Stroe avg value
                     color_patch_avgs.at<double>(mat_row, mat_col) = (double)avg;
                 }
@@ -70,6 +74,93 @@ cv::Mat btrgb::calibration::build_camra_signals_matrix(Image* art[], int art_cou
     return camra_sigs;
 }
 
+cv::Mat btrgb::calibration::apply_calibration_float(Image* art[], int art_count, cv::Mat M, cv::Mat offsets){
+    int height = art[0]->height();
+    int width = art[0]->width();
+    int in_chan = 0;
+    for(int art_i = 0; art_i < art_count; art_i++)
+        in_chan += art[art_i]->channels();
+    int out_chan = M.rows;
+    if(M.cols != in_chan || (int)offsets.total() != in_chan)
+        throw std::logic_error("[apply_calibration_float] M/offsets do not match the number of art channels.");
+
+    // Copy M and offsets into contiguous float arrays. M and offsets are usually croppings of a larger matrix.
+    std::vector<float> m(out_chan * in_chan);
+    std::vector<float> off(in_chan);
+    for(int row = 0; row < out_chan; row++)
+        for(int col = 0; col < in_chan; col++)
+            m[col + row * in_chan] = (float)M.at<double>(row, col);
+    for(int i = 0; i < in_chan; i++)
+        off[i] = (float)offsets.at<double>(i);
+
+    cv::Mat result(height, width, CV_MAKETYPE(CV_32F, out_chan));
+    btrgb::ThreadPool::get_instance()->parallel_for(0, height, [&](int start, int end) {
+        std::vector<float> sigs(in_chan);
+        for(int row = start; row < end; row++){
+            float* out_px = result.ptr<float>(row);
+            for(int col = 0; col < width; col++){
+                // Gather the offset camera signals of every art image for this pixel
+                int sig_i = 0;
+                for(int art_i = 0; art_i < art_count; art_i++){
+                    float* px = art[art_i]->getPixelPointer(row, col);
+                    for(int chan = 0; chan < art[art_i]->channels(); chan++, sig_i++)
+                        sigs[sig_i] = px[chan] - off[sig_i];
+                }
+                // out = M * sigs
+                const float* m_row = m.data();
+                for(int out_ch = 0; out_ch < out_chan; out_ch++, m_row += in_chan){
+                    float acc = 0;
+                    for(int i = 0; i < in_chan; i++){
+                        #ifdef FP_FAST_FMAF
+                        acc = std::fmaf(m_row[i], sigs[i], acc);
+                        #else
+                        acc += m_row[i] * sigs[i];
+                        #endif
+                    }
+                    out_px[out_ch] = acc;
+                }
+                out_px += out_chan;
+            }
+        }
+    });
+    return result;
+}
+
+double btrgb::calibration::validate_calibration_float(Image* art[], int art_count, cv::Mat M, cv::Mat offsets, cv::Mat result, int sample_count){
+    int height = art[0]->height();
+    int width = art[0]->width();
+    long pixel_count = (long)height * width;
+    if(sample_count <= 0 || pixel_count == 0)
+        return 0;
+    // Evenly spaced samples over the whole image
+    long stride = pixel_count / sample_count;
+    if(stride < 1)
+        stride = 1;
+
+    double max_deviation = 0;
+    int out_chan = M.rows;
+    for(long px_i = 0; px_i < pixel_count; px_i += stride){
+        int row = px_i / width;
+        int col = px_i % width;
+        const float* result_px = result.ptr<float>(row) + col * out_chan;
+        for(int out_ch = 0; out_ch < out_chan; out_ch++){
+            // Double precision reference, the same math as M * build_camra_signals_matrix
+            double ref = 0;
+            int sig_i = 0;
+            for(int art_i = 0; art_i < art_count; art_i++){
+                for(int chan = 0; chan < art[art_i]->channels(); chan++, sig_i++){
+                    double sig = (double)art[art_i]->getPixel(row, col, chan) - offsets.at<double>(sig_i);
+                    ref += M.at<double>(out_ch, sig_i) * sig;
+                }
+            }
+            double deviation = std::abs(ref - (double)result_px[out_ch]) * 0xFFFF;
+            if(deviation > max_deviation)
+                max_deviation = deviation;
+        }
+    }
+    return max_deviation;
+}
+
 cv::Mat btrgb::calibration::apply_offsets(cv::Mat camera_sigs, cv::Mat offsets){
     int row_count = camera_sigs.rows;
     int col_count = camera_sigs.cols;
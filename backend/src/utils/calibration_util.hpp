@@ -25,6 +25,7 @@ namespace btrgb{
          *       cp_avg_chan2_patch_1, cp_avg_chan2_patch_2, ..., cp_avg_chan2_patch_k
          *       ...                 , ...                 , ..., ...
          *       cp_avg_chan6_patch_1, cp_avg_chan6_patch_2, ..., cp_avg_chan6_patch_k 
+         * What "average" means is decided by the PatchStatistic of each target (mean by default)
          * @param targets an array of color targets
          * @param target_count the number of color targets
          * @param channel_count the number of channels (M) this Matrix will hold
@@ -50,6 +51,38 @@ namespace btrgb{
          */
         cv::Mat build_camra_signals_matrix(Image* images[], int art_count, int channel_count, cv::Mat* offsets=nullptr);
 
+        /**
+         * @brief Single precision equivalent of M * build_camra_signals_matrix(art, art_count, channel_count, &offsets)
+         * Instead of building a double precision MxN matrix, M and the offsets are applied to every pixel directly
+         * in float (using fused multiply-add when the target supports it) and written straight to an image shaped result.
+         * 
+         *  result is an image of the same height and width as the art images where each pixel is
+         *      m_1_1 * (px_ch1 - offset1) + m_1_2 * (px_ch2 - offset2) + ... + m_1_M * (px_chM - offsetM)
+         *      ...
+         *      m_K_1 * (px_ch1 - offset1) + m_K_2 * (px_ch2 - offset2) + ... + m_K_M * (px_chM - offsetM)
+         * 
+         * @param art an array of art Images to get pixel values from
+         * @param art_count the number of art images provided
+         * @param M KxM transformation matrix (CV_64F) where M is the total number of channels of all art images
+         * @param offsets 1xM matrix of offsets (CV_64F)
+         * @return cv::Mat CV_32FC(K) image
+         */
+        cv::Mat apply_calibration_float(Image* art[], int art_count, cv::Mat M, cv::Mat offsets);
+
+        /**
+         * @brief Validates the result of apply_calibration_float against a double precision reference
+         * A subset of pixels (evenly spaced over the image) is recomputed in double and compared with the float result.
+         * 
+         * @param art the same art images given to apply_calibration_float
+         * @param art_count the number of art images provided
+         * @param M the same transformation matrix given to apply_calibration_float
+         * @param offsets the same offsets given to apply_calibration_float
+         * @param result the image returned by apply_calibration_float
+         * @param sample_count the number of pixels to compare
+         * @return double the max deviation found, in 16 bit code values (ie. scaled by 0xFFFF)
+         */
+        double validate_calibration_float(Image* art[], int art_count, cv::Mat M, cv::Mat offsets, cv::Mat result, int sample_count = 4096);
+
         /**
          * @brief Create a matrix with the given offsets applied to the values of given camera sigs
          * 
@@ -0,0 +1,26 @@
+#include "cancellation_token.hpp"
+
+void btrgb::CancellationToken::cancel() {
+    this->cancelled = true;
+}
+
+void btrgb::CancellationToken::set_deadline(long timeout_ms) {
+    clock::time_point end = clock::now() + std::chrono::milliseconds(timeout_ms);
+    this->deadline = end.time_since_epoch().count();
+    this->has_deadline = true;
+}
+
+bool btrgb::CancellationToken::is_cancelled() {
+    return this->cancelled || this->deadline_passed();
+}
+
+void btrgb::CancellationToken::throw_if_cancelled() {
+    if (this->cancelled)
+        throw OperationCancelled();
+    if (this->deadline_passed())
+        throw OperationCancelled(true);
+}
+
+bool btrgb::CancellationToken::deadline_passed() {
+    return this->has_deadline && clock::now().time_since_epoch().count() >= this->deadline;
+}
@@ -0,0 +1,66 @@
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace btrgb {
+
+    /**
+     * @brief Shared flag used to stop a running process cooperatively
+     * The process holds the token and checks it at safe points (between pipeline stages, between images,
+     * every row of a per pixel loop, ...). Anyone else holding the token can cancel it.
+     * A deadline can also be set, once it passes the token counts as cancelled.
+     * 
+     * To use
+     *      - Call throw_if_cancelled() at safe points
+     *      - Let the OperationCancelled exception unwind, anything owned by unique_ptrs/ArtObjects gets released
+     *      - Catch OperationCancelled at the top of the process and report it
+     */
+    class CancellationToken {
+    public:
+        /**
+         * @brief Request the process holding this token to stop
+         */
+        void cancel();
+
+        /**
+         * @brief Set a deadline the process must finish by
+         * 
+         * @param timeout_ms the number of milliseconds from now
+         */
+        void set_deadline(long timeout_ms);
+
+        /**
+         * @brief Check if the token has been cancelled or the deadline has passed
+         */
+        bool is_cancelled();
+
+        /**
+         * @brief Throw OperationCancelled if the token has been cancelled or the deadline has passed
+         */
+        void throw_if_cancelled();
+
+    private:
+        typedef std::chrono::steady_clock clock;
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> has_deadline{false};
+        std::atomic<clock::rep> deadline{0};
+
+        bool deadline_passed();
+    };
+
+    class OperationCancelled : public std::exception {
+        private:
+            std::string msg;
+        public:
+            OperationCancelled(bool deadline = false) {
+                this->msg = deadline ? "Operation cancelled: deadline exceeded." : "Operation cancelled.";
+            }
+            virtual char const * what() const noexcept { return this->msg.c_str(); }
+    };
+
+}
+
+#endif // CANCELLATION_TOKEN_H
@@ -53,6 +53,48 @@ void CMDArgManager::set_option(std::string key, std::string value) {
     if (key == "--port") {
         GlobalsSinglton::get_instance()->set_port(std::stoi(value));
     }
+    if (key == "--calibration_precision") {
+        value = toLowerCase(value);
+        GlobalsSinglton::get_instance()->set_float_calibration(value != "double");
+    }
+    if (key == "--pool_retention_mb") {
+        GlobalsSinglton::get_instance()->set_pool_retention_mb(std::stoi(value));
+    }
+    if (key == "--huge_pages") {
+        value = toLowerCase(value);
+        GlobalsSinglton::get_instance()->set_huge_pages(value == "true");
+    }
+    if (key == "--scratch_dir") {
+        GlobalsSinglton::get_instance()->set_scratch_dir(value);
+    }
+    if (key == "--memory_budget_mb") {
+        GlobalsSinglton::get_instance()->set_memory_budget_mb(std::stoi(value));
+    }
+    if (key == "--cache_dir") {
+        GlobalsSinglton::get_instance()->set_cache_dir(value);
+    }
+    if (key == "--cache_mb") {
+        GlobalsSinglton::get_instance()->set_cache_mb(std::stoi(value));
+    }
+    if (key == "--cache_compression") {
+        value = toLowerCase(value);
+        GlobalsSinglton::get_instance()->set_cache_compression(value == "true");
+    }
+    if (key == "--threads") {
+        GlobalsSinglton::get_instance()->set_threads(std::stoi(value));
+    }
+    if (key == "--prefetch_mb") {
+        GlobalsSinglton::get_instance()->set_prefetch_mb(std::stoi(value));
+    }
+    if (key == "--decode_cache_mb") {
+        GlobalsSinglton::get_instance()->set_decode_cache_mb(std::stoi(value));
+    }
+    if (key == "--thumbnail_cache_mb") {
+        GlobalsSinglton::get_instance()->set_thumbnail_cache_mb(std::stoi(value));
+    }
+    if (key == "--tile_cache_mb") {
+        GlobalsSinglton::get_instance()->set_tile_cache_mb(std::stoi(value));
+    }
 }
 
 void CMDArgManager::handle_other(std::string arg) {
@@ -62,7 +104,20 @@ void CMDArgManager::handle_other(std::string arg) {
             "\toptions:\n"
             "\t --test_run=<bool>: set true to bypass server and run testfunc() in main.cpp, this defaults to false\n"
             "\t --port=<int>: The local network port for frontend/backend communication.\n"
-            "\t --app_root=<path>: set path for where applications resource folder can be found\n";
+            "\t --app_root=<path>: set path for where applications resource folder can be found\n"
+            "\t --calibration_precision=<float|double>: precision used when applying the calibration to the image, this defaults to float\n"
+            "\t --pool_retention_mb=<int>: most memory (MB) of freed image buffers kept for reuse, 0 disables pooling, this defaults to 1024\n"
+            "\t --huge_pages=<bool>: set true to back pooled image buffers with huge pages where supported, this defaults to false\n"
+            "\t --scratch_dir=<path>: directory for memory-mapped scratch files backing large images, this defaults to the system temp directory\n"
+            "\t --memory_budget_mb=<int>: image memory (MB) above which new large images are moved to scratch files, 0 disables this, this defaults to 0\n"
+            "\t --cache_dir=<path>: directory for checkpoints re-runs resume from, this defaults to the system temp directory\n"
+            "\t --cache_mb=<int>: most disk space (MB) used by checkpoints, 0 disables them, this defaults to 8192\n"
+            "\t --cache_compression=<bool>: set true to compress checkpoints, slower but smaller, this defaults to false\n"
+            "\t --threads=<int>: most threads used for processing, shared between the running requests, 0 uses every core, this defaults to 0\n"
+            "\t --prefetch_mb=<int>: most memory (MB) of images decoded in the background for each preview request, ahead of processing, 0 disables this, this defaults to 2048\n"
+            "\t --decode_cache_mb=<int>: most memory (MB) of decoded images kept for reuse between requests, 0 disables this and prefetching, this defaults to 2048\n"
+            "\t --thumbnail_cache_mb=<int>: most disk space (MB) used by thumbnails kept between runs, in the thumbnails folder of cache_dir, 0 disables them, this defaults to 256\n"
+            "\t --tile_cache_mb=<int>: most memory (MB) of tile pyramids kept for the image viewer, 0 disables this, this defaults to 1024\n";
         std::cout << usage_str << std::endl;
     }
 }
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #define PSAPI_VERSION 2
+    #include <windows.h>
+    #include <psapi.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+#else
+    #include <fstream>
+    #include <unistd.h>
+#endif
+
+#include "memory_tracker.hpp"
+
+namespace btrgb {
+
+    namespace {
+        std::atomic<int64_t> total_current{0};
+        std::atomic<int64_t> total_peak{0};
+        std::atomic<int64_t> rss_peak{0};
+        thread_local MemoryAccount* bound_account = nullptr;
+        // The allocator that actually provides the memory, set by install()
+        cv::MatAllocator* base_allocator = nullptr;
+
+        void raise_peak(std::atomic<int64_t>& peak, int64_t value) {
+            int64_t prev = peak.load(std::memory_order_relaxed);
+            while (prev < value && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed));
+        }
+    }
+
+    /* ============[ MemoryAccount ]============== */
+
+    std::shared_ptr<MemoryAccount> MemoryAccount::create(std::string name) {
+        // The shared_ptr owns one reference, Mats charged to the account own the others
+        return std::shared_ptr<MemoryAccount>(new MemoryAccount(name), [](MemoryAccount* account) {
+            account->release();
+        });
+    }
+
+    MemoryAccount::MemoryAccount(std::string name) {
+        this->name_m = name;
+    }
+
+    MemoryAccount* MemoryAccount::current() {
+        return bound_account;
+    }
+
+    MemoryAccount::Bind::Bind(MemoryAccount* account) {
+        this->previous = bound_account;
+        bound_account = account;
+    }
+
+    MemoryAccount::Bind::~Bind() {
+        bound_account = this->previous;
+    }
+
+    std::string MemoryAccount::name() {
+        return this->name_m;
+    }
+
+    int64_t MemoryAccount::current_bytes() {
+        return this->current;
+    }
+
+    int64_t MemoryAccount::peak_bytes() {
+        return this->peak;
+    }
+
+    std::string MemoryAccount::stage() {
+        std::unique_lock<std::mutex> lock(this->stage_mutex);
+        return this->open_stages.empty() ? "" : this->open_stages.back()->name;
+    }
+
+    std::string MemoryAccount::stage_summary() {
+        std::unique_lock<std::mutex> lock(this->stage_mutex);
+        std::stringstream summary;
+        summary << std::fixed << std::setprecision(1);
+        for (int i = 0; i < this->stage_peaks.size(); i++) {
+            if (i > 0)
+                summary << "; ";
+            summary << this->stage_peaks[i].first << " " << this->stage_peaks[i].second / (1024.0 * 1024.0) << "MB";
+        }
+        return summary.str();
+    }
+
+    void MemoryAccount::charge(int64_t bytes) {
+        int64_t now = this->current += bytes;
+        raise_peak(this->peak, now);
+        if (this->open_stage_count.load(std::memory_order_relaxed) > 0) {
+            std::unique_lock<std::mutex> lock(this->stage_mutex);
+            for (MemoryStage* stage : this->open_stages)
+                raise_peak(stage->peak, now);
+        }
+    }
+
+    void MemoryAccount::discharge(int64_t bytes) {
+        this->current -= bytes;
+    }
+
+    void MemoryAccount::retain() {
+        this->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void MemoryAccount::release() {
+        if (this->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    /* ============[ MemoryStage ]============== */
+
+    MemoryStage::MemoryStage(std::string name) {
+        this->account = MemoryAccount::current();
+        if (nullptr == this->account)
+            return;
+        this->name = name;
+        std::unique_lock<std::mutex> lock(this->account->stage_mutex);
+        this->peak = this->account->current;
+        this->account->open_stages.push_back(this);
+        this->account->open_stage_count++;
+    }
+
+    MemoryStage::~MemoryStage() {
+        if (nullptr == this->account)
+            return;
+        std::unique_lock<std::mutex> lock(this->account->stage_mutex);
+        int64_t peak = this->peak;
+        // Stages of components running side by side can end in any order
+        std::erase(this->account->open_stages, this);
+        this->account->open_stage_count--;
+        for (auto& [stage_name, stage_peak] : this->account->stage_peaks) {
+            if (stage_name == this->name) {
+                stage_peak = std::max(stage_peak, peak);
+                return;
+            }
+        }
+        this->account->stage_peaks.push_back(std::make_pair(this->name, peak));
+    }
+
+    int64_t MemoryStage::peak_bytes() {
+        if (nullptr == this->account)
+            return 0;
+        return this->peak;
+    }
+
+    /* ============[ MemoryTracker ]============== */
+
+    void MemoryTracker::install(cv::MatAllocator* base) {
+        base_allocator = (nullptr != base) ? base : cv::Mat::getStdAllocator();
+        // Never deleted, Mats may be freed during static destruction
+        static TrackingMatAllocator* allocator = new TrackingMatAllocator;
+        cv::Mat::setDefaultAllocator(allocator);
+    }
+
+    int64_t MemoryTracker::current_bytes() {
+        return total_current;
+    }
+
+    int64_t MemoryTracker::peak_bytes() {
+        return total_peak;
+    }
+
+    int64_t MemoryTracker::rss_bytes() {
+        int64_t rss = 0;
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            rss = counters.WorkingSetSize;
+#elif defined(__APPLE__)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+            rss = info.resident_size;
+#else
+        // Second field is the resident page count
+        std::ifstream statm("/proc/self/statm");
+        int64_t pages_total, pages_resident;
+        if (statm >> pages_total >> pages_resident)
+            rss = pages_resident * sysconf(_SC_PAGESIZE);
+#endif
+        raise_peak(rss_peak, rss);
+        return rss;
+    }
+
+    int64_t MemoryTracker::peak_rss_bytes() {
+        rss_bytes();
+        return rss_peak;
+    }
+
+    /* ============[ TrackingMatAllocator ]============== */
+
+    cv::UMatData* TrackingMatAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+
+        cv::UMatData* u = base_allocator->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        if (nullptr == u)
+            return u;
+        // Freeing must come back through this allocator
+        u->currAllocator = this;
+        u->userdata = nullptr;
+
+        // Data owned by the caller isn't counted
+        if (nullptr != data)
+            return u;
+
+        int64_t bytes = u->size;
+        raise_peak(total_peak, total_current += bytes);
+        MemoryAccount* account = MemoryAccount::current();
+        if (nullptr != account) {
+            account->retain();
+            account->charge(bytes);
+            u->userdata = account;
+        }
+        return u;
+    }
+
+    bool TrackingMatAllocator::allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const {
+        return base_allocator->allocate(data, accessflags, usageFlags);
+    }
+
+    void TrackingMatAllocator::deallocate(cv::UMatData* u) const {
+        if (nullptr == u)
+            return;
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            int64_t bytes = u->size;
+            total_current -= bytes;
+            MemoryAccount* account = (MemoryAccount*) u->userdata;
+            if (nullptr != account) {
+                account->discharge(bytes);
+                account->release();
+            }
+        }
+        u->userdata = nullptr;
+        base_allocator->deallocate(u);
+    }
+
+}
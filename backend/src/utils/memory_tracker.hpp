@@ -0,0 +1,158 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief Bytes of cv::Mat data charged to one request
+     * Every Mat allocated by a thread that has the account bound (see MemoryAccount::Bind) is charged to it
+     * until the Mat is freed, even if that happens after the request is done or on another thread.
+     *
+     * The account also keeps the peak of each stage (see MemoryStage) the request went through.
+     */
+    class MemoryStage;
+
+    class MemoryAccount {
+    public:
+        /**
+         * @brief Create an account, it is freed once the returned pointer and
+         * every Mat charged to it are gone
+         */
+        static std::shared_ptr<MemoryAccount> create(std::string name);
+
+        /**
+         * @brief The account bound to the calling thread, nullptr if none
+         */
+        static MemoryAccount* current();
+
+        /**
+         * @brief Binds an account to the calling thread for the life of the Bind
+         */
+        class Bind {
+        public:
+            Bind(MemoryAccount* account);
+            ~Bind();
+        private:
+            MemoryAccount* previous;
+        };
+
+        std::string name();
+        int64_t current_bytes();
+        int64_t peak_bytes();
+
+        /**
+         * @brief The innermost stage currently running, empty if none
+         */
+        std::string stage();
+
+        /**
+         * @brief Peak bytes of each stage, in the order they first ran
+         * ex: "Reading 812.0MB; Flat Fielding 1630.4MB"
+         */
+        std::string stage_summary();
+
+        void charge(int64_t bytes);
+        void discharge(int64_t bytes);
+        void retain();
+        void release();
+
+    private:
+        friend class MemoryStage;
+        MemoryAccount(std::string name);
+
+        std::string name_m;
+        std::atomic<int> refs{1};
+        std::atomic<int64_t> current{0};
+        std::atomic<int64_t> peak{0};
+
+        // Every charge raises the peak of each open stage, stages running side by side don't touch each other's
+        std::mutex stage_mutex;
+        std::atomic<int> open_stage_count{0};
+        std::vector<MemoryStage*> open_stages;
+        std::vector<std::pair<std::string, int64_t>> stage_peaks;
+    };
+
+    /**
+     * @brief Tracks the peak bytes of the account bound to the calling thread while it is in scope
+     * Stages can be nested or run side by side on other threads, each one keeps its own peak.
+     * A stage's peak is of the whole account, so it includes whatever else runs at the same time.
+     * Does nothing if no account is bound.
+     */
+    class MemoryStage {
+    public:
+        MemoryStage(std::string name);
+        ~MemoryStage();
+
+        MemoryStage(const MemoryStage&) = delete;
+        MemoryStage& operator=(const MemoryStage&) = delete;
+
+        /**
+         * @brief Peak bytes of the account since this stage started
+         */
+        int64_t peak_bytes();
+
+    private:
+        friend class MemoryAccount;
+        MemoryAccount* account;
+        std::string name;
+        std::atomic<int64_t> peak{0};
+    };
+
+    /**
+     * @brief Process wide memory numbers
+     *
+     * To use
+     *      - Call install() once at startup, before any Mat is allocated
+     *      - Every Mat allocated after that is counted
+     */
+    class MemoryTracker {
+    public:
+        /**
+         * @brief Make the tracking allocator the default allocator of every cv::Mat
+         * @param base the allocator that provides the memory, OpenCV's standard allocator if nullptr.
+         *  It must never be deleted.
+         */
+        static void install(cv::MatAllocator* base = nullptr);
+
+        /**
+         * @brief Bytes of Mat data currently allocated and the most ever allocated at once
+         */
+        static int64_t current_bytes();
+        static int64_t peak_bytes();
+
+        /**
+         * @brief Resident set size of the process, 0 if it can't be read on this platform.
+         * Every call is also a sample for peak_rss_bytes()
+         */
+        static int64_t rss_bytes();
+        /**
+         * @brief Largest resident set size seen, the current one is sampled first
+         */
+        static int64_t peak_rss_bytes();
+    };
+
+    /**
+     * @brief Wraps the base Mat allocator given to MemoryTracker::install(), counting every allocation
+     * toward the process totals and the account of the allocating thread.
+     */
+    class TrackingMatAllocator : public cv::MatAllocator {
+    public:
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+            cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+        bool allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const override;
+        void deallocate(cv::UMatData* data) const override;
+    };
+
+}
+
+#endif // MEMORY_TRACKER_H
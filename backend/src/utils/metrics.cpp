@@ -0,0 +1,129 @@
+#include <chrono>
+
+#include "metrics.hpp"
+
+namespace btrgb {
+
+    /* ============[ Throughput ]============== */
+
+    int64_t Throughput::now_sec() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void Throughput::record(int64_t pixels, int64_t duration_ns) {
+        int64_t sec = Throughput::now_sec();
+        Bucket& bucket = this->buckets[sec % WINDOW_SEC];
+
+        // First record of this second claims the bucket and clears what was left from a minute ago.
+        // A record racing the claim may be lost, that is fine for a rolling rate.
+        int64_t old_sec = bucket.second.load(std::memory_order_acquire);
+        if (old_sec != sec && bucket.second.compare_exchange_strong(old_sec, sec, std::memory_order_acq_rel)) {
+            bucket.pixels.store(0, std::memory_order_relaxed);
+            bucket.busy_ns.store(0, std::memory_order_relaxed);
+        }
+        bucket.pixels.fetch_add(pixels, std::memory_order_relaxed);
+        bucket.busy_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+    }
+
+    double Throughput::megapixels_per_sec() {
+        int64_t sec = Throughput::now_sec();
+        int64_t pixels = 0;
+        int64_t busy_ns = 0;
+        for (Bucket& bucket : this->buckets) {
+            if (sec - bucket.second.load(std::memory_order_acquire) >= WINDOW_SEC)
+                continue;
+            pixels += bucket.pixels.load(std::memory_order_relaxed);
+            busy_ns += bucket.busy_ns.load(std::memory_order_relaxed);
+        }
+        if (busy_ns <= 0)
+            return 0;
+        return (pixels / 1e6) / (busy_ns / 1e9);
+    }
+
+    int64_t Throughput::pixels() {
+        int64_t sec = Throughput::now_sec();
+        int64_t pixels = 0;
+        for (Bucket& bucket : this->buckets) {
+            if (sec - bucket.second.load(std::memory_order_acquire) < WINDOW_SEC)
+                pixels += bucket.pixels.load(std::memory_order_relaxed);
+        }
+        return pixels;
+    }
+
+    /* ============[ Metrics ]============== */
+
+    std::mutex Metrics::mutex;
+    std::map<std::string, std::unique_ptr<Counter>> Metrics::counters;
+    std::map<std::string, std::unique_ptr<Gauge>> Metrics::gauges;
+    std::map<std::string, std::unique_ptr<Throughput>> Metrics::throughputs;
+
+    Counter& Metrics::counter(std::string name) {
+        std::unique_lock<std::mutex> lock(Metrics::mutex);
+        std::unique_ptr<Counter>& c = Metrics::counters[name];
+        if (nullptr == c)
+            c.reset(new Counter);
+        return *c;
+    }
+
+    Gauge& Metrics::gauge(std::string name) {
+        std::unique_lock<std::mutex> lock(Metrics::mutex);
+        std::unique_ptr<Gauge>& g = Metrics::gauges[name];
+        if (nullptr == g)
+            g.reset(new Gauge);
+        return *g;
+    }
+
+    Throughput& Metrics::throughput(std::string name) {
+        std::unique_lock<std::mutex> lock(Metrics::mutex);
+        std::unique_ptr<Throughput>& t = Metrics::throughputs[name];
+        if (nullptr == t)
+            t.reset(new Throughput);
+        return *t;
+    }
+
+    jsoncons::json Metrics::snapshot() {
+        std::unique_lock<std::mutex> lock(Metrics::mutex);
+
+        const std::string HITS = ".hits";
+        const std::string MISSES = ".misses";
+        jsoncons::json counters;
+        jsoncons::json caches;
+        for (auto& [name, counter] : Metrics::counters) {
+            counters.insert_or_assign(name, counter->get());
+
+            if (name.size() <= HITS.size() || name.compare(name.size() - HITS.size(), HITS.size(), HITS) != 0)
+                continue;
+            std::string cache_name = name.substr(0, name.size() - HITS.size());
+            int64_t hits = counter->get();
+            int64_t misses = Metrics::counters.contains(cache_name + MISSES) ? Metrics::counters[cache_name + MISSES]->get() : 0;
+            jsoncons::json cache;
+            cache.insert_or_assign("hits", hits);
+            cache.insert_or_assign("misses", misses);
+            cache.insert_or_assign("hitRate", (hits + misses) > 0 ? double(hits) / (hits + misses) : 0.0);
+            caches.insert_or_assign(cache_name, cache);
+        }
+
+        jsoncons::json gauges;
+        for (auto& [name, gauge] : Metrics::gauges)
+            gauges.insert_or_assign(name, gauge->get());
+
+        jsoncons::json throughput;
+        for (auto& [name, t] : Metrics::throughputs) {
+            jsoncons::json stage;
+            stage.insert_or_assign("megapixelsPerSec", t->megapixels_per_sec());
+            stage.insert_or_assign("pixels", t->pixels());
+            throughput.insert_or_assign(name, stage);
+        }
+
+        jsoncons::json metrics;
+        metrics.insert_or_assign("counters", counters);
+        metrics.insert_or_assign("caches", caches);
+        metrics.insert_or_assign("gauges", gauges);
+        metrics.insert_or_assign("throughput", throughput);
+        metrics.insert_or_assign("windowSec", Throughput::WINDOW_SEC);
+        return metrics;
+    }
+
+}
@@ -0,0 +1,103 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief A count that only goes up, ex: cache hits
+     */
+    class Counter {
+    public:
+        void add(int64_t n = 1) { this->value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t get() { return this->value.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<int64_t> value{0};
+    };
+
+    /**
+     * @brief A value that goes up and down, ex: bytes held by a cache
+     */
+    class Gauge {
+    public:
+        void set(int64_t v) { this->value.store(v, std::memory_order_relaxed); }
+        void add(int64_t n) { this->value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t get() { return this->value.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<int64_t> value{0};
+    };
+
+    /**
+     * @brief Pixels processed and time spent processing them over the last WINDOW_SEC seconds
+     * Work is added to one bucket per second, buckets older than the window are ignored and
+     * reused once their second comes around again.
+     */
+    class Throughput {
+    public:
+        static const int WINDOW_SEC = 60;
+
+        /**
+         * @brief Add a finished piece of work
+         *
+         * @param pixels the number of pixels processed
+         * @param duration_ns how long processing them took
+         */
+        void record(int64_t pixels, int64_t duration_ns);
+
+        /**
+         * @brief Megapixels per second of processing time within the window, 0 if nothing ran
+         */
+        double megapixels_per_sec();
+
+        /**
+         * @brief Pixels processed within the window
+         */
+        int64_t pixels();
+
+    private:
+        struct Bucket {
+            std::atomic<int64_t> second{-1};
+            std::atomic<int64_t> pixels{0};
+            std::atomic<int64_t> busy_ns{0};
+        };
+        Bucket buckets[WINDOW_SEC];
+
+        static int64_t now_sec();
+    };
+
+    /**
+     * @brief Named metrics of the whole backend
+     * Looking up a metric takes a lock, updating it doesn't, so hot paths should keep the reference
+     * (metrics are never removed).
+     *
+     * Counters ending in ".hits" and ".misses" are reported together as a cache with a hit rate.
+     */
+    class Metrics {
+    public:
+        static Counter& counter(std::string name);
+        static Gauge& gauge(std::string name);
+        static Throughput& throughput(std::string name);
+
+        /**
+         * @brief Every metric as json, for the Stats response
+         */
+        static jsoncons::json snapshot();
+
+    private:
+        static std::mutex mutex;
+        static std::map<std::string, std::unique_ptr<Counter>> counters;
+        static std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        static std::map<std::string, std::unique_ptr<Throughput>> throughputs;
+    };
+
+}
+
+#endif // METRICS_H
@@ -0,0 +1,175 @@
+#include <filesystem>
+#include <iostream>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include "scratch_allocator.hpp"
+#include "utils/memory_tracker.hpp"
+#include "utils/metrics.hpp"
+
+namespace btrgb {
+
+    ScratchAllocator::ScratchAllocator() {
+        this->directory = (std::filesystem::temp_directory_path() / "btrgb_scratch").string();
+    }
+
+    ScratchAllocator* ScratchAllocator::get_instance() {
+        // Never deleted, Mats may be freed during static destruction
+        static ScratchAllocator* instance = new ScratchAllocator;
+        return instance;
+    }
+
+    void ScratchAllocator::set_directory(std::string dir) {
+        this->directory = dir;
+    }
+
+    std::string ScratchAllocator::get_directory() {
+        return this->directory;
+    }
+
+    void ScratchAllocator::set_memory_budget(size_t bytes) {
+        this->memory_budget = bytes;
+    }
+
+    bool ScratchAllocator::is_scratch(cv::Mat m) {
+        return nullptr != m.u && m.u->currAllocator == ScratchAllocator::get_instance();
+    }
+
+    bool ScratchAllocator::over_budget(cv::Mat m) {
+        size_t budget = this->memory_budget;
+        if (budget == 0 || m.empty())
+            return false;
+        size_t bytes = m.total() * m.elemSize();
+        return bytes >= MIN_SCRATCH_SIZE && MemoryTracker::current_bytes() > (int64_t) budget;
+    }
+
+    cv::Mat ScratchAllocator::to_scratch(cv::Mat m) {
+        if (m.empty() || ScratchAllocator::is_scratch(m))
+            return m;
+        try {
+            cv::Mat scratch;
+            scratch.allocator = this;
+            scratch.create(m.dims, m.size.p, m.type());
+            m.copyTo(scratch);
+            return scratch;
+        }
+        catch (const std::exception& e) {
+            // Out of disk space or similar, keeping it in RAM is the best that can be done
+            std::cerr << "Failed to move image to scratch: " << e.what() << std::endl;
+            return m;
+        }
+    }
+
+    int64_t ScratchAllocator::scratch_bytes() {
+        return this->mapped_bytes;
+    }
+
+    cv::UMatData* ScratchAllocator::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+
+        // Same layout as OpenCV's standard allocator
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                }
+                else {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+
+        cv::UMatData* u = new cv::UMatData(this);
+        u->size = total;
+        if (nullptr != data0) {
+            u->data = u->origdata = (uchar*) data0;
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+            return u;
+        }
+        if (total == 0) {
+            delete u;
+            throw ScratchError("Can not map an empty image.");
+        }
+
+        std::filesystem::create_directories(this->directory);
+        std::string path;
+
+#if defined(_WIN32)
+        path = (std::filesystem::path(this->directory) / ("btrgb_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(this->file_count++) + ".scratch")).string();
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW,
+            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            delete u;
+            throw ScratchError("Failed to create " + path);
+        }
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, DWORD(uint64_t(total) >> 32), DWORD(total & 0xFFFFFFFF), NULL);
+        void* data = (NULL == mapping) ? NULL : MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, total);
+        if (NULL != mapping)
+            CloseHandle(mapping); // The view keeps the mapping alive
+        if (NULL == data) {
+            CloseHandle(file);
+            delete u;
+            throw ScratchError("Failed to map " + path);
+        }
+        // Closing the file deletes it
+        u->handle = file;
+#else
+        path = (std::filesystem::path(this->directory) / ("btrgb_" + std::to_string(getpid()) + "_" + std::to_string(this->file_count++) + ".scratch")).string();
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            delete u;
+            throw ScratchError("Failed to create " + path);
+        }
+        void* data = MAP_FAILED;
+        if (ftruncate(fd, total) == 0)
+            data = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        // The mapping keeps the data, the name isn't needed anymore
+        close(fd);
+        unlink(path.c_str());
+        if (data == MAP_FAILED) {
+            delete u;
+            throw ScratchError("Failed to map " + path);
+        }
+#endif
+        u->data = u->origdata = (uchar*) data;
+        this->mapped_bytes += total;
+        static Gauge& scratch_gauge = Metrics::gauge("scratch.bytes");
+        scratch_gauge.set(this->mapped_bytes);
+        return u;
+    }
+
+    bool ScratchAllocator::allocate(cv::UMatData* u, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const {
+        return nullptr != u;
+    }
+
+    void ScratchAllocator::deallocate(cv::UMatData* u) const {
+        if (nullptr == u)
+            return;
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED) && nullptr != u->origdata) {
+#if defined(_WIN32)
+            UnmapViewOfFile(u->origdata);
+            CloseHandle((HANDLE) u->handle);
+#else
+            munmap(u->origdata, u->size);
+#endif
+            this->mapped_bytes -= u->size;
+            static Gauge& scratch_gauge = Metrics::gauge("scratch.bytes");
+            scratch_gauge.set(this->mapped_bytes);
+            u->origdata = 0;
+        }
+        delete u;
+    }
+
+}
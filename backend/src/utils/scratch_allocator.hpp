@@ -0,0 +1,90 @@
+#ifndef SCRATCH_ALLOCATOR_H
+#define SCRATCH_ALLOCATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+namespace btrgb {
+
+    /**
+     * @brief Allocates Mat data in memory-mapped scratch files instead of RAM
+     * The kernel pages the data in and out as it is used, so images that don't fit
+     * in memory slow the run down instead of crashing the backend.
+     *
+     * Each Mat gets its own file in the scratch directory. The file is removed as soon as it is
+     * mapped (POSIX) or opened delete-on-close (Windows), so nothing is left behind even after a crash.
+     *
+     * To use
+     *      - cv::Mat m; m.allocator = ScratchAllocator::get_instance(); m.create(...);
+     *      - or to_scratch() to move an existing Mat
+     */
+    class ScratchAllocator : public cv::MatAllocator {
+    public:
+        // Smaller images are never worth a file of their own
+        static const size_t MIN_SCRATCH_SIZE = 16 * 1024 * 1024;
+
+        static ScratchAllocator* get_instance();
+
+        /**
+         * @brief Set where scratch files are created, the directory is created if needed
+         */
+        void set_directory(std::string dir);
+        std::string get_directory();
+
+        /**
+         * @brief Set the most bytes of image data to keep in RAM, 0 for no limit
+         */
+        void set_memory_budget(size_t bytes);
+
+        /**
+         * @brief Check if the Mat's data is held in a scratch file
+         */
+        static bool is_scratch(cv::Mat m);
+
+        /**
+         * @brief Check if a Mat of this size should go to scratch to stay within the memory budget
+         */
+        bool over_budget(cv::Mat m);
+
+        /**
+         * @brief Copy the Mat into a scratch file
+         * @return the scratch backed copy, or m itself if it already is scratch backed, is empty
+         *  or the scratch file couldn't be created
+         */
+        cv::Mat to_scratch(cv::Mat m);
+
+        /**
+         * @brief Bytes currently held in scratch files
+         */
+        int64_t scratch_bytes();
+
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+            cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+        bool allocate(cv::UMatData* data, cv::AccessFlag accessflags, cv::UMatUsageFlags usageFlags) const override;
+        void deallocate(cv::UMatData* data) const override;
+
+    private:
+        ScratchAllocator();
+
+        std::string directory;
+        std::atomic<size_t> memory_budget{0};
+        mutable std::atomic<int64_t> mapped_bytes{0};
+        mutable std::atomic<uint64_t> file_count{0};
+    };
+
+    class ScratchError : public std::exception {
+        private:
+            std::string msg;
+        public:
+            ScratchError(std::string msg) {
+                this->msg = "[ScratchAllocator] " + msg;
+            }
+            virtual char const * what() const noexcept { return  this->msg.c_str(); }
+    };
+
+}
+
+#endif // SCRATCH_ALLOCATOR_H
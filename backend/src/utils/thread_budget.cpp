@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <thread>
+
+#include <opencv2/core.hpp>
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "thread_budget.hpp"
+#include "utils/metrics.hpp"
+
+namespace btrgb {
+
+    ThreadBudget::ThreadBudget() {
+        this->total_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ThreadBudget* ThreadBudget::get_instance() {
+        static ThreadBudget instance;
+        return &instance;
+    }
+
+    void ThreadBudget::set_total(int threads) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->total_threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        this->apply();
+    }
+
+    int ThreadBudget::total() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->total_threads;
+    }
+
+    int ThreadBudget::active_count() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return this->active;
+    }
+
+    int ThreadBudget::share() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return std::max(1, this->total_threads / std::max(1, this->active));
+    }
+
+    void ThreadBudget::limit_thread() {
+#ifdef _OPENMP
+        omp_set_num_threads(this->share());
+#endif
+    }
+
+    void ThreadBudget::apply() {
+        int share = std::max(1, this->total_threads / std::max(1, this->active));
+        // OpenCV has one thread pool for the whole process, every request's parallel loops share it
+        cv::setNumThreads(share);
+        static Gauge& share_gauge = Metrics::gauge("threads.share");
+        share_gauge.set(share);
+    }
+
+    /* ============[ Share ]============== */
+
+    ThreadBudget::Share::Share() {
+        ThreadBudget* budget = ThreadBudget::get_instance();
+        {
+            std::unique_lock<std::mutex> lock(budget->mutex);
+            budget->active++;
+            budget->apply();
+        }
+        budget->limit_thread();
+    }
+
+    ThreadBudget::Share::~Share() {
+        ThreadBudget* budget = ThreadBudget::get_instance();
+        std::unique_lock<std::mutex> lock(budget->mutex);
+        budget->active--;
+        budget->apply();
+    }
+
+}
@@ -0,0 +1,67 @@
+#ifndef THREAD_BUDGET_H
+#define THREAD_BUDGET_H
+
+#include <mutex>
+
+namespace btrgb {
+
+    /**
+     * @brief Splits the threads the backend may use between the requests that are running
+     *
+     * OpenCV, OpenMP (LibRaw) and the ThreadPool all size themselves from the budget, so running several
+     * requests at once doesn't start several times more threads than there are cores. Each running request
+     * gets an equal share, which changes as requests start and finish.
+     *
+     * To use
+     *      // On the thread running the request, for as long as it runs
+     *      ThreadBudget::Share share;
+     */
+    class ThreadBudget {
+    public:
+        static ThreadBudget* get_instance();
+
+        /**
+         * @brief Set the most threads to use, 0 uses one per core
+         * Must be set before the ThreadPool is first used, it is sized from this.
+         */
+        void set_total(int threads);
+        int total();
+
+        int active_count();
+
+        /**
+         * @brief Threads each running request gets, at least 1
+         */
+        int share();
+
+        /**
+         * @brief Limit OpenMP on the calling thread to the current share
+         * For threads a request starts for itself, the request's own thread is limited by Share.
+         */
+        void limit_thread();
+
+        /**
+         * @brief Counts the calling thread's request as running for the life of the Share
+         */
+        class Share {
+        public:
+            Share();
+            ~Share();
+
+            Share(const Share&) = delete;
+            Share& operator=(const Share&) = delete;
+        };
+
+    private:
+        ThreadBudget();
+        // Called with mutex held whenever the share changes
+        void apply();
+
+        std::mutex mutex;
+        int total_threads;
+        int active = 0;
+    };
+
+}
+
+#endif // THREAD_BUDGET_H
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <chrono>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "thread_pool.hpp"
+#include "utils/memory_tracker.hpp"
+#include "utils/thread_budget.hpp"
+
+namespace btrgb {
+
+    // The pool and queue index of the worker running on this thread, if any
+    static thread_local ThreadPool* current_pool = nullptr;
+    static thread_local int current_worker = -1;
+
+    /* ============[ ThreadPool ]============== */
+
+    ThreadPool* ThreadPool::get_instance() {
+        static ThreadPool instance(std::max(2, ThreadBudget::get_instance()->total()));
+        return &instance;
+    }
+
+    ThreadPool::ThreadPool(int threads) {
+        for (int i = 0; i < threads; i++)
+            this->queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
+        for (int i = 0; i < threads; i++)
+            this->workers.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->available.notify_all();
+        for (std::thread& worker : this->workers)
+            worker.join();
+    }
+
+    int ThreadPool::size() {
+        return this->workers.size();
+    }
+
+    void ThreadPool::submit(task_t task) {
+        MemoryAccount* account = MemoryAccount::current();
+        if (nullptr != account)
+            account->retain();
+        task_t wrapped = [task = std::move(task), account]() {
+            {
+                MemoryAccount::Bind bind(account);
+                task();
+            }
+            if (nullptr != account)
+                account->release();
+        };
+
+        if (current_pool == this) {
+            WorkerQueue* queue = this->queues[current_worker].get();
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->tasks.push_back(std::move(wrapped));
+        }
+        else {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->shared_tasks.push_back(std::move(wrapped));
+        }
+        this->queued++;
+        // Notified under the lock so a worker about to wait can't miss it
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->available.notify_one();
+    }
+
+    bool ThreadPool::take(task_t& task) {
+        if (this->queued.load() == 0)
+            return false;
+
+        // Own queue first, newest task since its data is most likely still in cache
+        int own = (current_pool == this) ? current_worker : -1;
+        if (own >= 0) {
+            WorkerQueue* queue = this->queues[own].get();
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            if (!queue->tasks.empty()) {
+                task = std::move(queue->tasks.back());
+                queue->tasks.pop_back();
+                this->queued--;
+                return true;
+            }
+        }
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (!this->shared_tasks.empty()) {
+                task = std::move(this->shared_tasks.front());
+                this->shared_tasks.pop_front();
+                this->queued--;
+                return true;
+            }
+        }
+        // Steal the oldest task of another worker
+        int count = this->queues.size();
+        for (int i = 1; i <= count; i++) {
+            int victim = (std::max(own, 0) + i) % count;
+            if (victim == own)
+                continue;
+            WorkerQueue* queue = this->queues[victim].get();
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            if (!queue->tasks.empty()) {
+                task = std::move(queue->tasks.front());
+                queue->tasks.pop_front();
+                this->queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ThreadPool::run_one() {
+        task_t task;
+        if (!this->take(task))
+            return false;
+        task();
+        return true;
+    }
+
+    void ThreadPool::parallel_for(int begin, int end, std::function<void(int, int)> body) {
+        int length = end - begin;
+        if (length <= 0)
+            return;
+        int ranges = std::min(length, ThreadBudget::get_instance()->share());
+        if (ranges <= 1) {
+            body(begin, end);
+            return;
+        }
+
+        /* Unlike TaskGroup::wait() the caller never runs other queued tasks, only ranges of this loop.
+         * Loops run while holding locks (e.g. building an image's patch statistics) and an unrelated
+         * task run on the same thread could try to take the same lock. */
+        struct Loop {
+            std::atomic<int> next{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            int done = 0;
+            std::exception_ptr error;
+        };
+        std::shared_ptr<Loop> loop(new Loop);
+        // Helpers that start after every range was taken return without touching body
+        auto run_ranges = [loop, &body, begin, length, ranges]() {
+            int i;
+            while ((i = loop->next++) < ranges) {
+                std::exception_ptr error;
+                try {
+                    body(begin + int(int64_t(length) * i / ranges), begin + int(int64_t(length) * (i + 1) / ranges));
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                std::unique_lock<std::mutex> lock(loop->mutex);
+                if (error && !loop->error)
+                    loop->error = error;
+                if (++loop->done == ranges)
+                    loop->finished.notify_all();
+            }
+        };
+        for (int i = 1; i < ranges; i++)
+            this->submit(run_ranges);
+        run_ranges();
+
+        std::unique_lock<std::mutex> lock(loop->mutex);
+        loop->finished.wait(lock, [&]() { return loop->done == ranges; });
+        if (loop->error)
+            std::rethrow_exception(loop->error);
+    }
+
+    void ThreadPool::work(int index) {
+        current_pool = this;
+        current_worker = index;
+#ifdef _OPENMP
+        // The pool already runs one task per core, OpenMP inside a task would only oversubscribe
+        omp_set_num_threads(1);
+#endif
+        while (true) {
+            task_t task;
+            if (this->take(task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->available.wait(lock, [this]() { return this->stopping || this->queued.load() > 0; });
+            if (this->stopping && this->queued.load() == 0)
+                return;
+        }
+    }
+
+    /* ============[ TaskGroup ]============== */
+
+    ThreadPool::TaskGroup::TaskGroup(ThreadPool* pool) {
+        this->pool = pool;
+    }
+
+    ThreadPool::TaskGroup::~TaskGroup() {
+        try {
+            this->wait();
+        }
+        catch (...) {}
+    }
+
+    void ThreadPool::TaskGroup::run(task_t task) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->pending++;
+        }
+        this->pool->submit([this, task = std::move(task)]() {
+            std::exception_ptr error;
+            try {
+                task();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (error && !this->error)
+                this->error = error;
+            // Notified under the lock, the group may be destroyed as soon as the waiter sees 0
+            if (--this->pending == 0)
+                this->done.notify_all();
+        });
+    }
+
+    void ThreadPool::TaskGroup::wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (this->pending > 0) {
+            lock.unlock();
+            bool ran = this->pool->run_one();
+            lock.lock();
+            // Nothing to help with, the remaining tasks are running on other threads
+            if (!ran && this->pending > 0)
+                this->done.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        if (this->error) {
+            std::exception_ptr error = this->error;
+            this->error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+}
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace btrgb {
+
+    /**
+     * @brief Worker threads shared by every request for running independent pieces of work concurrently
+     *
+     * One worker per thread of the ThreadBudget. Each worker has its own queue: tasks queued from a worker go
+     * on its own queue and are run newest first, idle workers steal the oldest tasks from the other queues.
+     * Tasks queued from other threads go on a shared queue.
+     *
+     * Threads waiting on work they queued (TaskGroup::wait()) run queued tasks in the meantime,
+     * so work can queue more work and wait for it without starving the pool.
+     *
+     * To use
+     *      ThreadPool::TaskGroup group;
+     *      group.run([&]() { ... });
+     *      group.run([&]() { ... });
+     *      group.wait();
+     */
+    class ThreadPool {
+    public:
+        typedef std::function<void()> task_t;
+
+        static ThreadPool* get_instance();
+        ~ThreadPool();
+
+        int size();
+
+        /**
+         * @brief Queue a task, it must not throw
+         * The memory account bound to the calling thread is bound while the task runs.
+         */
+        void submit(task_t task);
+
+        /**
+         * @brief Run one queued task on the calling thread
+         * @return false if nothing was queued
+         */
+        bool run_one();
+
+        /**
+         * @brief Split [begin, end) into about as many ranges as the calling request's share of threads
+         * and run body on each range concurrently, returns once every range is done
+         * For loops that would otherwise use cv::parallel_for_, so they share the pool with everything else.
+         * Safe to call while holding a lock, the calling thread only runs ranges of this loop while it waits.
+         */
+        void parallel_for(int begin, int end, std::function<void(int, int)> body);
+
+        /**
+         * @brief Tasks that are waited on together
+         * The first exception thrown by any of them is rethrown by wait().
+         */
+        class TaskGroup {
+        public:
+            TaskGroup(ThreadPool* pool = ThreadPool::get_instance());
+            // Waits for anything still running, exceptions are dropped
+            ~TaskGroup();
+
+            TaskGroup(const TaskGroup&) = delete;
+            TaskGroup& operator=(const TaskGroup&) = delete;
+
+            void run(task_t task);
+
+            /**
+             * @brief Wait for every task run so far, running queued tasks while waiting
+             */
+            void wait();
+
+        private:
+            ThreadPool* pool;
+            std::mutex mutex;
+            std::condition_variable done;
+            int pending = 0;
+            std::exception_ptr error;
+        };
+
+    private:
+        ThreadPool(int threads);
+        void work(int index);
+        bool take(task_t& task);
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<task_t> tasks;
+        };
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        // Tasks queued by threads that aren't workers
+        std::deque<task_t> shared_tasks;
+        std::atomic<int> queued{0};
+        std::mutex mutex;
+        std::condition_variable available;
+        std::vector<std::thread> workers;
+        bool stopping = false;
+    };
+
+}
+
+#endif // THREAD_POOL_H
@@ -1,39 +1,31 @@
 #include "time_tracker.hpp"
 
 void TimeTracker::start_timeing(){
-    this->initial = time(0);
+    this->initial = std::chrono::steady_clock::now();
 }
 
 void TimeTracker::end_timeing(){
-    this->end = time(0);
+    this->end = std::chrono::steady_clock::now();
 }
 
-int TimeTracker::get_elapsed_sec(){
-    return this->end - this->initial;
+int TimeTracker::get_elapsed_ms(){
+    return std::chrono::duration_cast<std::chrono::milliseconds>(this->end - this->initial).count();
 }
 
 int TimeTracker::elapsed_time_sec(){
-    int sec = this->get_elapsed_sec();
+    int sec = this->get_elapsed_ms() / 1000;
     std::cout << "Elapesed sec: " << sec << std::endl;
     return sec;
 }
 
 int TimeTracker::elapsed_time_ms(){
-    int ms = this->sec2ms(this->get_elapsed_sec());
+    int ms = this->get_elapsed_ms();
     std::cout << "Elapesed ms: " << ms << std::endl;
     return ms;
 }
 
 float TimeTracker::elapsed_time_min(){
-    float min = this->sec2min(this->get_elapsed_sec());
+    float min = this->get_elapsed_ms() / 60000.0f;
     std::cout << "Elapesed min: " << min << std::endl;
     return min;
 }
-
-int TimeTracker::sec2ms(int sec){
-    return sec * 1000;
-}
-
-float TimeTracker::sec2min(int sec){
-    return sec / 60.0f;
-}
\ No newline at end of file
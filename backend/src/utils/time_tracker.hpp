@@ -2,10 +2,12 @@
 #define TIME_TRACKER_H
 
 #include <iostream>
-#include <ctime>
+#include <chrono>
 
 /**
  * @brief Helper class for timing various tasks
+ * Uses the monotonic steady clock, so it has (at least) millisecond resolution
+ * and is not affected by changes to the system time.
  * 
  * To use 
  *      - Create an instance of the TimeTracker
@@ -50,12 +52,10 @@ public:
     float elapsed_time_min();
 
 private:
-    time_t initial;
-    time_t end;
+    std::chrono::steady_clock::time_point initial;
+    std::chrono::steady_clock::time_point end;
 
-    int get_elapsed_sec();
-    float sec2min(int sec);
-    int sec2ms(int sec);
+    int get_elapsed_ms();
 };
 
 #endif //TIME_TRACKER_H
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <jsoncons/json.hpp>
+
+#include "trace.hpp"
+
+namespace btrgb {
+
+    Trace::Trace() {
+        this->origin_ns = Trace::now_ns();
+    }
+
+    int64_t Trace::now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void Trace::record(TraceEvent event) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->events.push_back(std::move(event));
+    }
+
+    bool Trace::write_chrome_json(std::string filename) {
+        std::vector<TraceEvent> events;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            events = this->events;
+        }
+
+        // Chrome wants small integer thread ids, number them in order of first appearance
+        std::map<std::thread::id, int> thread_ids;
+        jsoncons::json trace_events = jsoncons::json::make_array();
+        for (const TraceEvent& event : events) {
+            if (!thread_ids.contains(event.thread)) {
+                int tid = thread_ids.size() + 1;
+                thread_ids[event.thread] = tid;
+            }
+            jsoncons::json e;
+            e.insert_or_assign("name", event.name);
+            e.insert_or_assign("cat", event.category);
+            e.insert_or_assign("ph", "X");
+            // Microseconds from the start of the run
+            e.insert_or_assign("ts", (event.start_ns - this->origin_ns) / 1000.0);
+            e.insert_or_assign("dur", event.duration_ns / 1000.0);
+            e.insert_or_assign("pid", 1);
+            e.insert_or_assign("tid", thread_ids[event.thread]);
+            jsoncons::json args;
+            if (event.bytes >= 0)
+                args.insert_or_assign("bytes", event.bytes);
+            if (event.pixels >= 0)
+                args.insert_or_assign("pixels", event.pixels);
+            for (const auto& [name, value] : event.args)
+                args.insert_or_assign(name, value);
+            e.insert_or_assign("args", args);
+            trace_events.push_back(e);
+        }
+
+        jsoncons::json trace;
+        trace.insert_or_assign("traceEvents", trace_events);
+        trace.insert_or_assign("displayTimeUnit", "ms");
+
+        std::ofstream trace_stream(filename);
+        if (!trace_stream.is_open())
+            return false;
+        std::string json_string;
+        trace.dump(json_string);
+        trace_stream << json_string;
+        trace_stream.close();
+        return true;
+    }
+
+    std::string Trace::summary(std::string category) {
+        std::vector<TraceEvent> events;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            events = this->events;
+        }
+        // Spans are recorded when they end, sort so parents come before their children
+        std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+            return a.start_ns < b.start_ns;
+        });
+
+        std::vector<std::string> order;
+        std::map<std::string, int64_t> totals;
+        for (const TraceEvent& event : events) {
+            if (event.category != category)
+                continue;
+            if (!totals.contains(event.name))
+                order.push_back(event.name);
+            totals[event.name] += event.duration_ns;
+        }
+
+        std::stringstream summary;
+        summary << std::fixed << std::setprecision(1);
+        for (int i = 0; i < order.size(); i++) {
+            if (i > 0)
+                summary << "; ";
+            summary << order[i] << " " << totals[order[i]] / 1e6 << "ms";
+        }
+        return summary.str();
+    }
+
+
+
+    TraceSpan::TraceSpan(Trace* trace, std::string name, std::string category) {
+        this->trace = trace;
+        if (nullptr == trace)
+            return;
+        this->event.name = name;
+        this->event.category = category;
+        this->event.thread = std::this_thread::get_id();
+        this->event.start_ns = Trace::now_ns();
+    }
+
+    TraceSpan::~TraceSpan() {
+        if (nullptr == this->trace)
+            return;
+        this->event.duration_ns = Trace::now_ns() - this->event.start_ns;
+        this->trace->record(std::move(this->event));
+    }
+
+    void TraceSpan::set_bytes(int64_t bytes) {
+        this->event.bytes = bytes;
+    }
+
+    void TraceSpan::set_pixels(int64_t pixels) {
+        this->event.pixels = pixels;
+    }
+
+    void TraceSpan::set_arg(std::string name, int64_t value) {
+        this->event.args.push_back(std::make_pair(name, value));
+    }
+
+}
@@ -0,0 +1,103 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Name of the trace file written into the output directory of a run
+#define TRACE_FILE "BTRGB_Trace.json"
+
+namespace btrgb {
+
+    /**
+     * @brief A finished span, times are in nanoseconds on the steady clock
+     */
+    struct TraceEvent {
+        std::string name;
+        std::string category;
+        int64_t start_ns;
+        int64_t duration_ns;
+        std::thread::id thread;
+        // -1 when not reported
+        int64_t bytes = -1;
+        int64_t pixels = -1;
+        // Any other numbers to show with the span
+        std::vector<std::pair<std::string, int64_t>> args;
+    };
+
+    /**
+     * @brief Collects the spans of one run so they can be written as a Chrome/Perfetto trace
+     * Spans can be recorded from any thread.
+     *
+     * To use
+     *      - Create a Trace for the run and attach it to the ArtObject
+     *      - Put a TraceSpan on the stack around anything that should be timed
+     *      - When the run is done call write_chrome_json()
+     *      - The trace can be opened with chrome://tracing or ui.perfetto.dev
+     */
+    class Trace {
+    public:
+        Trace();
+
+        /**
+         * @brief Monotonic time in nanoseconds
+         */
+        static int64_t now_ns();
+
+        void record(TraceEvent event);
+
+        /**
+         * @brief Write every recorded span in the Chrome trace event format
+         *
+         * @param filename the file to write to
+         * @return true if the file was written
+         */
+        bool write_chrome_json(std::string filename);
+
+        /**
+         * @brief Total time of each span of the given category, in the order they first started
+         * ex: "Image Reader 812.4ms; Flat Fielding 310.2ms"
+         *
+         * @param category the category to summarize
+         * @return std::string
+         */
+        std::string summary(std::string category);
+
+    private:
+        std::mutex mutex;
+        int64_t origin_ns;
+        std::vector<TraceEvent> events;
+    };
+
+    /**
+     * @brief Times the scope it lives in and records it to a Trace when destroyed
+     * Does nothing if the trace is nullptr, so it can be used unconditionally.
+     */
+    class TraceSpan {
+    public:
+        TraceSpan(Trace* trace, std::string name, std::string category = "step");
+        ~TraceSpan();
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        /**
+         * @brief Report how much data the span processed, shown in the span's args
+         */
+        void set_bytes(int64_t bytes);
+        void set_pixels(int64_t pixels);
+        void set_arg(std::string name, int64_t value);
+
+    private:
+        Trace* trace;
+        TraceEvent event;
+    };
+
+}
+
+#endif // TRACE_H